@@ -186,16 +186,22 @@ public:
         , mButton(button)
     {}
 
+    // Shared devices: begun by the first action, ended by the last
     bool begin() override {
         bool ok = true;
-        if (mLed) ok &= mLed->begin();
-        if (mButton) ok &= mButton->begin();
+        if (mLed) ok &= mLed->acquire();
+        if (mButton) ok &= mButton->acquire();
         return ok;
     }
 
     void end() override {
-        if (mLed) mLed->end();
-        if (mButton) mButton->end();
+        if (mLed) mLed->release();
+        if (mButton) mButton->release();
+    }
+
+    void useDevices() override {
+        if (mLed) mLed->use();
+        if (mButton) mButton->use();
     }
 
 protected:
@@ -227,8 +233,7 @@ public:
     }
 
     bool onRun() override {
-        checkButton();
-        return true;
+        return checkButton();   // work done only on a press
     }
 
     void onExit() override {
@@ -249,8 +254,7 @@ public:
     }
 
     bool onRun() override {
-        checkButton();
-        return true;
+        return checkButton();   // work done only on a press
     }
 
     void onExit() override {
@@ -276,12 +280,14 @@ public:
     }
 
     bool onRun() override {
+        bool toggled = false;
         if ((millis() - mLastToggleTime) >= mIntervalMs) {
             if (mLed) mLed->toggle();
             mLastToggleTime = millis();
+            toggled = true;
         }
-        checkButton();
-        return true;
+        bool pressed = checkButton();
+        return toggled || pressed;
     }
 
     void onExit() override {
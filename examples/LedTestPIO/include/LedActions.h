@@ -14,6 +14,7 @@ public:
 
     bool begin() override;
     void end() override;
+    void useDevices() override;
 
 protected:
     LED* mLed;
@@ -2,7 +2,7 @@
 #include "LedActions.h"
 
 // Helper to convert exit codes to readable names
-static const char* exitCodeName(uint8_t code) {
+static const char* exitCodeName(smExitCode_t code) {
     switch (code) {
         case EXIT_NONE:         return "NONE";
         case EXIT_COMPLETE:     return "COMPLETE";
@@ -24,16 +24,23 @@ LedButtonAction::LedButtonAction(LED* aLed, Button* aButton)
 {
 }
 
+// The LED and button are shared by every action: acquire() begins each
+// device once, release() ends it after the last action lets go
 bool LedButtonAction::begin() {
     bool ok = true;
-    if (mLed) ok &= mLed->begin();
-    if (mButton) ok &= mButton->begin();
+    if (mLed) ok &= mLed->acquire();
+    if (mButton) ok &= mButton->acquire();
     return ok;
 }
 
 void LedButtonAction::end() {
-    if (mLed) mLed->end();
-    if (mButton) mButton->end();
+    if (mLed) mLed->release();
+    if (mButton) mButton->release();
+}
+
+void LedButtonAction::useDevices() {
+    if (mLed) mLed->use();
+    if (mButton) mButton->use();
 }
 
 bool LedButtonAction::checkButton() {
@@ -62,8 +69,7 @@ void LedOffAction::onEnter() {
 }
 
 bool LedOffAction::onRun() {
-    checkButton();
-    return true;  // Keep running until exit requested
+    return checkButton();  // Work done only on a press
 }
 
 void LedOffAction::onExit() {
@@ -87,8 +93,7 @@ void LedOnAction::onEnter() {
 }
 
 bool LedOnAction::onRun() {
-    checkButton();
-    return true;
+    return checkButton();
 }
 
 void LedOnAction::onExit() {
@@ -118,13 +123,15 @@ void LedBlinkAction::onEnter() {
 
 bool LedBlinkAction::onRun() {
     // Blink LED
+    bool toggled = false;
     if ((millis() - mLastToggleTime) >= mIntervalMs) {
         if (mLed) mLed->toggle();
         mLastToggleTime = millis();
+        toggled = true;
     }
 
-    checkButton();
-    return true;
+    bool pressed = checkButton();
+    return toggled || pressed;
 }
 
 void LedBlinkAction::onExit() {
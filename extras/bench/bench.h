@@ -0,0 +1,66 @@
+#pragma once
+
+// =============================================================================
+// bench.h - Host benchmark harness for the SM framework
+// =============================================================================
+// Benchmarks register themselves with SM_BENCH(name) and report results with
+// benchReport(). Every result is printed as one JSON object per line:
+//
+//   {"bench":"transitions","config":"index","param":"states=16",
+//    "value":1234567.0,"unit":"transitions/s"}
+//
+// "config" identifies the library build (SM_BENCH_CONFIG) so results from
+// different compile-time options can be compared side by side.
+// =============================================================================
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SM_BENCH_CONFIG
+#define SM_BENCH_CONFIG "default"
+#endif
+
+typedef void (*smBenchFn)();
+
+struct smBenchEntry {
+    const char* name;
+    smBenchFn fn;
+    smBenchEntry* next;
+};
+
+class smBenchRegister {
+public:
+    smBenchRegister(const char* name, smBenchFn fn);
+};
+
+#define SM_BENCH(name) \
+    static void name(); \
+    static smBenchRegister name##_register(#name, name); \
+    static void name()
+
+// Monotonic time in nanoseconds
+uint64_t benchNowNs();
+
+// Emit one result line
+void benchReport(const char* bench, const char* param, double value, const char* unit);
+
+// Keep a value alive so the optimizer cannot drop the work producing it
+template <typename T>
+inline void benchKeep(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Run fn(iterations) several times and return the best time per iteration (ns)
+template <typename F>
+double benchBestNs(F fn, uint32_t iterations, int repeats = 5) {
+    double best = 0;
+    for (int r = 0; r < repeats; r++) {
+        uint64_t t0 = benchNowNs();
+        fn(iterations);
+        double ns = (double)(benchNowNs() - t0) / iterations;
+        if (r == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
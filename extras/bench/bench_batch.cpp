@@ -0,0 +1,73 @@
+// =============================================================================
+// bench_batch.cpp - smBatch against N separate smMachine objects
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// Memory per instance and transitions per second for N instances of a
+// 4-state ring: every instance takes one transition per round
+SM_BENCH(batch) {
+    const smIndex_t numStates = 4;
+    const unsigned int counts[] = { 100, 1000, 10000 };
+    for (unsigned int n : counts) {
+        const uint32_t rounds = 2000000 / n + 1;
+        char param[48];
+
+        // Separate machines: one smMachine, its states, actions, table and
+        // index per instance
+        BenchMachine** machines = new BenchMachine*[n];
+        for (unsigned int i = 0; i < n; i++) {
+            machines[i] = new BenchMachine(numStates, 1, TASK_HOUR);
+            machines[i]->machine().start(machines[i]->state(0));
+        }
+        smMachine& m0 = machines[0]->machine();
+        size_t machineBytes = sizeof(BenchMachine) + sizeof(smMachine) +
+                              numStates * (sizeof(smState) + sizeof(BenchAction) + sizeof(smState*)) +
+                              machines[0]->numTransitions() * sizeof(smTransition) +
+                              m0.getIndexSize();
+        double ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t r = 0; r < iterations; r++) {
+                for (unsigned int i = 0; i < n; i++) {
+                    machines[i]->machine().requestTransition(EXIT_USER);
+                }
+            }
+        }, rounds, 3);
+        snprintf(param, sizeof(param), "instances=%u,engine=machines", n);
+        benchReport("batch", param, (double)machineBytes, "bytes/instance");
+        benchReport("batch", param, n * 1e9 / ns, "transitions/s");
+        for (unsigned int i = 0; i < n; i++) {
+            delete machines[i];
+        }
+        delete[] machines;
+
+        // One batch sharing the table of a single prototype machine
+        BenchMachine proto(numStates, 1);
+        smBatch batch(proto.states(), numStates, proto.transitions(), proto.numTransitions(), n);
+        batch.begin(0);
+        ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t r = 0; r < iterations; r++) {
+                for (unsigned int i = 0; i < n; i++) {
+                    batch.post(i, EXIT_USER);
+                }
+                benchKeep(batch.step());
+            }
+        }, rounds, 3);
+        snprintf(param, sizeof(param), "instances=%u,engine=batch", n);
+        benchReport("batch", param,
+                    (double)smBatch::getInstanceSize() + (double)(sizeof(smBatch) + batch.getTableSize()) / n,
+                    "bytes/instance");
+        benchReport("batch", param, n * 1e9 / ns, "transitions/s");
+
+        // step() alone with nothing pending (branch-free: same cost per pass)
+        ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t r = 0; r < iterations; r++) {
+                benchKeep(batch.step());
+            }
+        }, rounds, 3);
+        snprintf(param, sizeof(param), "instances=%u,engine=batch-idle-step", n);
+        benchReport("batch", param, ns / n, "ns/instance");
+    }
+}
@@ -0,0 +1,123 @@
+// =============================================================================
+// bench_bus.cpp - smBus fan-out by subscriber count and subscription kind
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+#define BENCH_BUS_EVENT     1
+#define BENCH_BUS_OTHER     2
+
+struct BenchReading {
+    int16_t value;
+    uint8_t sensor;
+};
+
+static void benchBusHandler(const smEvent& event, void* context) {
+    *static_cast<long*>(context) += event.as<BenchReading>().value;
+}
+
+// Publish one event and run the bus task: pool claim, queue, dispatch
+template <typename F>
+static double benchBusRound(smBus& bus, F&& check) {
+    return benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            bus.publish(BENCH_BUS_EVENT, BenchReading{ (int16_t)i, 1 });
+            bus.Callback();
+        }
+        check();
+    }, 1u << 14);
+}
+
+static void benchBusFanOut(unsigned int n) {
+    char param[32];
+    snprintf(param, sizeof(param), "subscribers=%u", n);
+
+    // Handlers: the payload read in place by every subscriber
+    {
+        smBus bus;
+        long sums[64] = { 0 };
+        for (unsigned int s = 0; s < n; s++) {
+            bus.subscribe(BENCH_BUS_EVENT, benchBusHandler, &sums[s]);
+        }
+        // Subscribers of other types are not walked
+        bus.subscribe(BENCH_BUS_OTHER, benchBusHandler, &sums[0]);
+        double ns = benchBusRound(bus, [&] { benchKeep(sums[n - 1]); });
+        benchReport("bus", param, ns, "ns/event handler");
+        benchReport("bus", param, ns / n, "ns/subscriber handler");
+    }
+
+    // n two-state machines bouncing on EXIT_USER: every state's action
+    // subscribed with the exit code (only the current one acts), or each
+    // machine subscribed for broadcast(); against the requestTransition()
+    // calls a shared-globals design makes itself
+    BenchMachine* machines[64];
+    for (unsigned int s = 0; s < n; s++) {
+        machines[s] = new BenchMachine(2, 1, TASK_HOUR);
+        machines[s]->machine().start(machines[s]->state(0));
+    }
+    auto check = [&] { benchKeep(machines[n - 1]->machine().getCurrentState()); };
+    {
+        smBus bus;
+        for (unsigned int s = 0; s < n; s++) {
+            bus.subscribe(BENCH_BUS_EVENT, machines[s]->action(0), EXIT_USER);
+            bus.subscribe(BENCH_BUS_EVENT, machines[s]->action(1), EXIT_USER);
+        }
+        double ns = benchBusRound(bus, check);
+        benchReport("bus", param, ns, "ns/event exit code");
+        benchReport("bus", param, ns / n, "ns/subscriber exit code");
+    }
+    {
+        smBus bus;
+        for (unsigned int s = 0; s < n; s++) {
+            bus.subscribe(BENCH_BUS_EVENT, machines[s]->machine(), EXIT_USER);
+        }
+        double ns = benchBusRound(bus, check);
+        benchReport("bus", param, ns, "ns/event broadcast");
+        benchReport("bus", param, ns / n, "ns/subscriber broadcast");
+    }
+    double direct = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            for (unsigned int s = 0; s < n; s++) {
+                machines[s]->machine().requestTransition(EXIT_USER);
+            }
+        }
+        check();
+    }, 1u << 14);
+    benchReport("bus", param, direct, "ns/event direct requestTransition");
+
+    for (unsigned int s = 0; s < n; s++) {
+        machines[s]->machine().stop();
+        delete machines[s];
+    }
+}
+
+SM_BENCH(bus) {
+    // Producer side alone: claim, write in place, commit (drained untimed)
+    smBus bus;
+    double publish = 0;
+    for (int r = 0; r < 5; r++) {
+        uint64_t ns = 0;
+        uint32_t n = 0;
+        while (n < (1u << 16)) {
+            uint64_t t0 = benchNowNs();
+            for (unsigned int i = 0; i < smBus::capacity(); i++) {
+                bus.publish(BENCH_BUS_EVENT, BenchReading{ (int16_t)i, 1 });
+            }
+            ns += benchNowNs() - t0;
+            n += smBus::capacity();
+            bus.Callback();
+        }
+        double each = (double)ns / n;
+        publish = (r == 0 || each < publish) ? each : publish;
+    }
+    benchReport("bus", "producer", publish, "ns/publish");
+    benchReport("bus", "producer", (double)sizeof(smBus), "bytes/bus");
+
+    const unsigned int counts[] = { 1, 4, 16, 64 };
+    for (unsigned int n : counts) {
+        benchBusFanOut(n);
+    }
+}
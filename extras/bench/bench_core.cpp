@@ -0,0 +1,143 @@
+// =============================================================================
+// bench_core.cpp - Core transition and dispatch benchmarks
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Transitions per second: every onRun() requests an exit, so each scheduler
+// pass performs one full transition (onExit, table lookup, onEnter)
+static void benchTransitions(uint8_t n, bool rtc) {
+    BenchMachine bm(n, 1);
+    for (uint8_t s = 0; s < n; s++) {
+        bm.action(s).mExitOnRun = EXIT_USER;
+    }
+    smMachine& m = bm.machine();
+    m.setRunToCompletion(rtc);
+    m.start(bm.state(0));
+
+    const uint64_t duration = 200000000ULL;  // 200 ms
+    unsigned long start = m.getTransitionCount();
+    uint64_t t0 = benchNowNs();
+    uint64_t t;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            m.execute();
+        }
+        t = benchNowNs();
+    } while (t - t0 < duration);
+    m.stop();
+
+    char param[32];
+    snprintf(param, sizeof(param), "states=%u%s", n, rtc ? ",rtc" : "");
+    benchReport("transitions", param,
+                (double)(m.getTransitionCount() - start) * 1e9 / (double)(t - t0),
+                "transitions/s");
+}
+
+// Directly and in run-to-completion mode
+SM_BENCH(transitions) {
+    const uint8_t sizes[] = { 2, 16, 64 };
+    for (uint8_t n : sizes) {
+        benchTransitions(n, false);
+    }
+    for (uint8_t n : sizes) {
+        benchTransitions(n, true);
+    }
+}
+
+// findNextState() latency against table size (hits on random rows)
+// (wide SM_INDEX_WIDTH builds add tables past 255 rows)
+SM_BENCH(lookup) {
+    struct { smIndex_t states; smIndex_t codes; } sizes[] = {
+        { 4, 2 }, { 8, 4 }, { 16, 8 }, { 63, 4 }, { 127, 2 },
+#if SM_INDEX_WIDTH > 8
+        { 256, 4 }, { 1024, 4 }, { 4096, 8 },
+#endif
+    };
+    const uint32_t numQueries = 4096;
+    smIndex_t* qState = new smIndex_t[numQueries];
+    smExitCode_t* qCode = new smExitCode_t[numQueries];
+
+    for (auto& sz : sizes) {
+        BenchMachine bm(sz.states, sz.codes);
+        smMachine& m = bm.machine();
+        srand(1);
+        for (uint32_t i = 0; i < numQueries; i++) {
+            qState[i] = (smIndex_t)(rand() % sz.states);
+            qCode[i] = (smExitCode_t)(EXIT_USER + rand() % sz.codes);
+        }
+        double ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                uint32_t q = i & (numQueries - 1);
+                benchKeep(m.findNextState(bm.state(qState[q]), qCode[q]));
+            }
+        }, 1u << 20);
+
+        char param[64];
+        snprintf(param, sizeof(param), "rows=%u,index=%s,bytes=%u", (unsigned)bm.numTransitions(),
+                 m.getIndexSize() == 0 ? "linear" : m.isIndexDense() ? "dense" : "ranges",
+                 (unsigned)m.getIndexSize());
+        benchReport("lookup", param, ns, "ns/lookup");
+    }
+    delete[] qState;
+    delete[] qCode;
+}
+
+// smState::Callback() dispatch overhead over a direct onRun() call, and the
+// cost of one scheduler pass that runs the current state
+SM_BENCH(dispatch) {
+    BenchMachine bm(2, 1);
+    smMachine& m = bm.machine();
+    smState* state = bm.state(0);
+    smAction* action = state->getAction();
+
+    double direct = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            benchKeep(action->onRun());
+        }
+    }, 1u << 22);
+    double callback = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            benchKeep(state->Callback());
+        }
+    }, 1u << 22);
+
+    m.start(state);
+    double pass = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.execute();
+        }
+    }, 1u << 20);
+    m.stop();
+
+    benchReport("dispatch", "onRun", direct, "ns/call");
+    benchReport("dispatch", "Callback", callback, "ns/call");
+    benchReport("dispatch", "Callback-overhead", callback - direct, "ns/call");
+    benchReport("dispatch", "execute-run", pass, "ns/pass");
+}
+
+// smMachine::execute() cost when the current state is not due
+SM_BENCH(idle) {
+    const uint8_t sizes[] = { 2, 16, 64 };
+    for (uint8_t n : sizes) {
+        BenchMachine bm(n, 1, TASK_HOUR);
+        smMachine& m = bm.machine();
+        m.start(bm.state(0));
+        m.execute();  // first run happens immediately after enable()
+
+        double ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                m.execute();
+            }
+        }, 1u << 20);
+        m.stop();
+
+        char param[32];
+        snprintf(param, sizeof(param), "states=%u", n);
+        benchReport("idle", param, ns, "ns/execute");
+    }
+}
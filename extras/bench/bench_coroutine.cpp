@@ -0,0 +1,157 @@
+// =============================================================================
+// bench_coroutine.cpp - smCoAction against hand-rolled timers (C++20 builds)
+// =============================================================================
+
+#include "bench.h"
+
+#include "StateMachine.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#if SM_COROUTINES
+
+static uint64_t benchCoCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static const unsigned long benchBlinkMs = 50;
+
+// LedBlinkAction style: compare millis() with the last toggle on every run
+class BenchTimerBlink : public smAction {
+public:
+    BenchTimerBlink() : smAction(nullptr, "BLINK"), mToggles(0), mLastToggle(0) {}
+
+    void onEnter() override { mLastToggle = millis(); }
+
+    bool onRun() override {
+        if (millis() - mLastToggle >= benchBlinkMs) {
+            mLastToggle = millis();
+            mToggles++;
+            return true;
+        }
+        return false;
+    }
+
+    unsigned long mToggles;
+    unsigned long mLastToggle;
+};
+
+// The same blink as a coroutine
+class BenchCoBlink : public smCoAction {
+public:
+    BenchCoBlink() : smCoAction(nullptr, "BLINK"), mToggles(0) {}
+
+    smCoTask run() override {
+        for (;;) {
+            co_await sleep(benchBlinkMs);
+            mToggles++;
+        }
+    }
+
+    unsigned long mToggles;
+};
+
+// State counting its runs
+class BenchCountingState : public smState {
+public:
+    BenchCountingState(smAction* action) : smState(action, "BLINK"), mRuns(0) {}
+
+    bool Callback() override {
+        mRuns++;
+        return smState::Callback();
+    }
+
+    unsigned long mRuns;
+};
+
+// One blinking state for 500 ms; the loop sleeps for whatever execute()
+// reports. Reports state runs per second and CPU load.
+template <typename A>
+static void benchBlink(const char* mode, A& action) {
+    BenchCountingState state(&action);
+    smState* states[] = { &state };
+    smMachine m(states, 1, nullptr, 0);
+    m.begin();
+    m.start(&state);
+
+    const unsigned long duration = 500;
+    unsigned long start = millis();
+    uint64_t cpu0 = benchCoCpuNs();
+    while (millis() - start < duration) {
+        unsigned long idle = m.execute();
+        unsigned long left = duration - (millis() - start);
+        delay(idle < left ? idle : left);
+    }
+    uint64_t cpu = benchCoCpuNs() - cpu0;
+    unsigned long elapsed = millis() - start;
+    m.stop();
+
+    char param[32];
+    snprintf(param, sizeof(param), "mode=%s", mode);
+    benchReport("coroutine", param, (double)state.mRuns * 1000.0 / elapsed, "wakeups/s");
+    benchReport("coroutine", param, (double)cpu / ((double)elapsed * 1e6) * 100.0, "%cpu");
+    benchReport("coroutine", param, (double)action.mToggles, "toggles");
+}
+
+// Coroutine that yields on every resume, driven directly (no state)
+class BenchCoYield : public smCoAction {
+public:
+    BenchCoYield() : smCoAction(nullptr, "YIELD"), mCount(0) {}
+
+    smCoTask run() override {
+        for (;;) {
+            co_await signaled();
+            mCount++;
+        }
+    }
+
+    unsigned long mCount;
+};
+
+class BenchCallYield : public smAction {
+public:
+    BenchCallYield() : smAction(nullptr, "YIELD"), mCount(0) {}
+
+    bool onRun() override {
+        mCount++;
+        return true;
+    }
+
+    unsigned long mCount;
+};
+
+SM_BENCH(coroutine) {
+    BenchTimerBlink timer;
+    benchBlink("timer", timer);
+    BenchCoBlink blink;
+    benchBlink("coroutine", blink);
+
+    // Through smAction*, as smState calls it
+    BenchCallYield call;
+    smAction* callAction = &call;
+    benchKeep(callAction);
+    double callNs = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            callAction->onRun();
+        }
+        benchKeep(call.mCount);
+    }, 1u << 20);
+    benchReport("coroutine", "onRun=virtual", callNs, "ns/run");
+
+    BenchCoYield co;
+    smAction* coAction = &co;
+    benchKeep(coAction);
+    double coNs = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            coAction->onRun();
+        }
+        benchKeep(co.mCount);
+    }, 1u << 20);
+    benchReport("coroutine", "onRun=resume", coNs, "ns/run");
+    benchReport("coroutine", "frame", (double)smCoPool::getLargestFrame(), "bytes");
+}
+
+#endif
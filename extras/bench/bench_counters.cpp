@@ -0,0 +1,79 @@
+// =============================================================================
+// bench_counters.cpp - Frequency-ordered table scans (SM_TRANSITION_COUNTERS)
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+#ifdef SM_TRANSITION_COUNTERS
+
+// Two hot states bouncing on EXIT_USER, their rows at the end of a table
+// whose other rows belong to a cold state that is never entered. Linear
+// scans (SM_LINEAR_LOOKUP builds) walk every cold row in table order; in
+// frequency order the hot rows come first.
+static void benchCounters(smIndex_t numRows, bool frequencyOrder) {
+    BenchAction actions[3];
+    smState hotA(&actions[0], "HOT_A", TASK_IMMEDIATE);
+    smState hotB(&actions[1], "HOT_B", TASK_IMMEDIATE);
+    smState cold(&actions[2], "COLD", TASK_IMMEDIATE);
+    smState* states[] = { &hotA, &hotB, &cold };
+    smTransition* rows = new smTransition[numRows]();
+    for (smIndex_t i = 0; i < numRows - 2; i++) {
+        rows[i].fromState = &cold;
+        rows[i].exitCondition = (smExitCode_t)(EXIT_USER + i);
+        rows[i].toState = &hotA;
+    }
+    rows[numRows - 2] = { &hotA, EXIT_USER, &hotB };
+    rows[numRows - 1] = { &hotB, EXIT_USER, &hotA };
+    actions[0].mExitOnRun = EXIT_USER;
+    actions[1].mExitOnRun = EXIT_USER;
+
+    smMachine m(states, 3, rows, numRows);
+    m.begin();
+    if (!m.setFrequencyOrder(frequencyOrder)) {
+        // Indexed builds: no scans to order
+        delete[] rows;
+        return;
+    }
+    m.start(&hotA);
+
+    // Warm up and sort once; the timed loop includes the periodic re-sorts
+    for (int i = 0; i < 1000; i++) {
+        m.execute();
+    }
+    m.reorder();
+    double ns = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.execute();
+        }
+    }, 1u << 16);
+    double sortNs = 0;
+    if (frequencyOrder) {
+        sortNs = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                m.reorder();
+            }
+        }, 1u << 8);
+    }
+    m.stop();
+    delete[] rows;
+
+    char param[48];
+    snprintf(param, sizeof(param), "rows=%u,order=%s", (unsigned)numRows, frequencyOrder ? "frequency" : "table");
+    benchReport("counters", param, ns, "ns/transition");
+    if (frequencyOrder) {
+        benchReport("counters", param, sortNs, "ns/reorder");
+    }
+}
+
+SM_BENCH(counters) {
+    const smIndex_t sizes[] = { 8, 64, 200 };
+    for (smIndex_t n : sizes) {
+        benchCounters(n, false);
+        benchCounters(n, true);
+    }
+}
+
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+// =============================================================================
+// bench_fsm.h - Synthetic machines for the host benchmarks
+// =============================================================================
+
+#include "StateMachine.h"
+
+// Action that optionally requests an exit every time it runs
+class BenchAction : public smAction {
+public:
+    BenchAction() : smAction(nullptr, "BENCH"), mExitOnRun(EXIT_NONE), mRuns(0) {}
+
+    bool onRun() override {
+        mRuns++;
+        if (mExitOnRun != EXIT_NONE) {
+            requestExit(mExitOnRun);
+        }
+        return true;
+    }
+
+    smExitCode_t mExitOnRun;
+    unsigned long mRuns;
+};
+
+// N states with `codes` exit codes per state; code k of state s leads to
+// state (s + k + 1) % N. Exit codes start at EXIT_USER. begin() is called
+// unless `begin` is false (e.g. to add regions first).
+class BenchMachine {
+public:
+    BenchMachine(smIndex_t numStates, smIndex_t codesPerState, unsigned long interval = TASK_IMMEDIATE,
+                 Scheduler* scheduler = nullptr, bool begin = true)
+        : mNumStates(numStates)
+    {
+        mActions = new BenchAction[numStates];
+        mStates = new smState*[numStates];
+        for (smIndex_t s = 0; s < numStates; s++) {
+            mStates[s] = new smState(&mActions[s], "BENCH", interval);
+        }
+        mNumTransitions = (smIndex_t)(numStates * codesPerState);
+        mTransitions = new smTransition[mNumTransitions]();
+        for (smIndex_t s = 0; s < numStates; s++) {
+            for (smIndex_t k = 0; k < codesPerState; k++) {
+                smTransition& t = mTransitions[s * codesPerState + k];
+                t.fromState = mStates[s];
+                t.exitCondition = EXIT_USER + k;
+                t.toState = mStates[(s + k + 1) % numStates];
+            }
+        }
+        mMachine = new smMachine(mStates, numStates, mTransitions, mNumTransitions, scheduler);
+        if (begin) {
+            mMachine->begin();
+        }
+    }
+
+    ~BenchMachine() {
+        // States leave the machine's scheduler before it goes away
+        for (smIndex_t s = 0; s < mNumStates; s++) {
+            delete mStates[s];
+        }
+        delete mMachine;
+        delete[] mStates;
+        delete[] mActions;
+        delete[] mTransitions;
+    }
+
+    smMachine& machine() { return *mMachine; }
+    smState* state(smIndex_t s) { return mStates[s]; }
+    smState** states() { return mStates; }
+    smTransition* transitions() { return mTransitions; }
+    BenchAction& action(smIndex_t s) { return mActions[s]; }
+    smIndex_t numStates() { return mNumStates; }
+    smIndex_t numTransitions() { return mNumTransitions; }
+
+private:
+    smIndex_t mNumStates;
+    smIndex_t mNumTransitions;
+    BenchAction* mActions;
+    smState** mStates;
+    smTransition* mTransitions;
+    smMachine* mMachine;
+};
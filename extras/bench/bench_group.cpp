@@ -0,0 +1,89 @@
+// =============================================================================
+// bench_group.cpp - smMachineGroup per-tick overhead against machine count
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// Per-tick cost of smMachineGroup::execute() with no state due, for
+// 10/100/1000 machines: all running and 10 running, each on its own
+// scheduler and all sharing one
+SM_BENCH(group) {
+    const unsigned int counts[] = { 10, 100, 1000 };
+    for (unsigned int n : counts) {
+        BenchMachine** machines = new BenchMachine*[n];
+        for (unsigned int i = 0; i < n; i++) {
+            machines[i] = new BenchMachine(2, 1, TASK_HOUR);
+        }
+
+        smMachineGroup group;
+        for (unsigned int i = 0; i < n; i++) {
+            group.add(machines[i]->machine());
+            machines[i]->machine().start(machines[i]->state(0));
+        }
+        group.execute();  // first run happens immediately after enable()
+
+        char param[48];
+        double ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                group.execute();
+            }
+        }, 200000 / n + 100);
+        snprintf(param, sizeof(param), "machines=%u,running=%u", n, n);
+        benchReport("group", param, ns, "ns/tick");
+
+        for (unsigned int i = 10; i < n; i++) {
+            machines[i]->machine().stop();
+        }
+        group.execute();  // drops stopped machines from the walk
+        ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                group.execute();
+            }
+        }, 20000);
+        snprintf(param, sizeof(param), "machines=%u,running=%u,stopped=%u", n, group.getActiveCount(),
+                 n - group.getActiveCount());
+        benchReport("group", param, ns, "ns/tick");
+
+        for (unsigned int i = 0; i < n; i++) {
+            delete machines[i];
+        }
+
+        // Shared scheduler: one pass over the running machines' current states
+        Scheduler shared;
+        smMachineGroup sharedGroup(&shared);
+        for (unsigned int i = 0; i < n; i++) {
+            machines[i] = new BenchMachine(2, 1, TASK_HOUR, &shared);
+            sharedGroup.add(machines[i]->machine());
+            machines[i]->machine().start(machines[i]->state(0));
+        }
+        sharedGroup.execute();
+        ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                sharedGroup.execute();
+            }
+        }, 200000 / n + 100);
+        snprintf(param, sizeof(param), "machines=%u,running=%u,shared", n, n);
+        benchReport("group", param, ns, "ns/tick");
+
+        for (unsigned int i = 10; i < n; i++) {
+            machines[i]->machine().stop();
+        }
+        sharedGroup.execute();  // drops stopped machines and their states
+        ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                sharedGroup.execute();
+            }
+        }, 20000);
+        snprintf(param, sizeof(param), "machines=%u,running=%u,stopped=%u,shared", n,
+                 sharedGroup.getActiveCount(), n - sharedGroup.getActiveCount());
+        benchReport("group", param, ns, "ns/tick");
+
+        for (unsigned int i = 0; i < n; i++) {
+            delete machines[i];
+        }
+        delete[] machines;
+    }
+}
@@ -0,0 +1,81 @@
+// =============================================================================
+// bench_guard.cpp - Guarded transition lookup (SM_TRANSITION_GUARDS builds)
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+#ifdef SM_TRANSITION_GUARDS
+
+// Guard k passes when the selector is k
+static volatile int benchSelector;
+
+template <int K>
+static bool benchGuard(smState*, smExitCode_t) {
+    return benchSelector == K;
+}
+
+static const smGuard benchGuards[] = { benchGuard<0>, benchGuard<1>, benchGuard<2>, benchGuard<3> };
+
+// 16 states; EXIT_USER leads to one of four states depending on the
+// selector, written either as four guarded rows sharing the exit code or
+// as four exit codes the action would have to pick from
+static void benchGuardTable(bool guarded) {
+    const smIndex_t numStates = 16;
+    const int candidates = 4;
+    BenchAction actions[numStates];
+    smState* states[numStates];
+    for (smIndex_t s = 0; s < numStates; s++) {
+        states[s] = new smState(&actions[s], "BENCH", TASK_HOUR);
+    }
+
+    smTransition rows[numStates * (candidates + 1)];
+    smIndex_t n = 0;
+    for (smIndex_t s = 0; s < numStates; s++) {
+        for (int k = 0; k < candidates; k++) {
+            smState* to = states[(s + k + 1) % numStates];
+            if (guarded) {
+                rows[n++] = { states[s], EXIT_USER, to, benchGuards[k] };
+            } else {
+                rows[n++] = { states[s], (smExitCode_t)(EXIT_USER + k), to, nullptr };
+            }
+        }
+        rows[n++] = { states[s], EXIT_ERROR, states[0], nullptr };
+    }
+
+    smMachine* m = new smMachine(states, numStates, rows, n);
+    m->begin();
+
+    const char* table = guarded ? "guarded" : "codes";
+    char param[64];
+    snprintf(param, sizeof(param), "states=16,table=%s,rows=%u", table, (unsigned)n);
+    benchReport("guard", param, (double)(n * sizeof(smTransition)), "table-bytes");
+    benchReport("guard", param, (double)m->getIndexSize(), "index-bytes");
+
+    // Candidate k passes: guarded tables call k + 1 guards
+    for (int k = 0; k < candidates; k += candidates - 1) {
+        benchSelector = k;
+        smExitCode_t code = guarded ? EXIT_USER : (smExitCode_t)(EXIT_USER + k);
+        double ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                benchKeep(m->findNextState(states[i % numStates], code));
+            }
+        }, 1u << 20);
+        snprintf(param, sizeof(param), "states=16,table=%s,candidate=%d", table, k + 1);
+        benchReport("guard", param, ns, "ns/lookup");
+    }
+
+    for (smIndex_t s = 0; s < numStates; s++) {
+        delete states[s];
+    }
+    delete m;
+}
+
+SM_BENCH(guard) {
+    benchGuardTable(false);
+    benchGuardTable(true);
+}
+
+#endif
@@ -0,0 +1,233 @@
+// =============================================================================
+// bench_hierarchy.cpp - Nested machines (smSubmachine) against copied rows
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+#define BENCH_LEVEL_STATES  8
+#define BENCH_ESCAPES       4
+#define BENCH_MAX_DEPTH     3
+#define BENCH_LEVEL_ROWS    (BENCH_LEVEL_STATES + BENCH_ESCAPES + 1)
+
+// Exit codes the composite state of `level` leaves on; the first also
+// returns from state 1 to the composite state
+static smExitCode_t benchEscape(unsigned int level, unsigned int j) {
+    return (smExitCode_t)(EXIT_USER + 1 + level * BENCH_ESCAPES + j);
+}
+
+// depth + 1 levels of BENCH_LEVEL_STATES states; state 0 of every level
+// but the last is a composite state running the next level from its
+// state 0. Every level chains its states on EXIT_USER; a composite state
+// also has BENCH_ESCAPES rows of its own to state 1, and state 1 one back.
+class BenchHierarchy {
+public:
+    BenchHierarchy(unsigned int depth) : mDepth(depth) {
+        // Deepest first, so each submachine can refer to its child
+        for (unsigned int l = depth + 1; l-- > 0;) {
+            Level& v = mLevels[l];
+            v.submachine = l < depth ? new smSubmachine(*mLevels[l + 1].machine, mLevels[l + 1].states[0]) : nullptr;
+            for (smIndex_t s = 0; s < BENCH_LEVEL_STATES; s++) {
+                smAction* action = s == 0 && v.submachine ? (smAction*)v.submachine : &v.actions[s];
+                v.states[s] = new smState(action, "BENCH", TASK_HOUR);
+            }
+            v.numRows = 0;
+            for (smIndex_t s = 0; s < BENCH_LEVEL_STATES; s++) {
+                v.rows[v.numRows++] = { v.states[s], EXIT_USER, v.states[(s + 1) % BENCH_LEVEL_STATES] };
+            }
+            if (l < depth) {
+                for (unsigned int j = 0; j < BENCH_ESCAPES; j++) {
+                    v.rows[v.numRows++] = { v.states[0], benchEscape(l, j), v.states[1] };
+                }
+                v.rows[v.numRows++] = { v.states[1], benchEscape(l, 0), v.states[0] };
+            }
+            v.machine = new smMachine(v.states, BENCH_LEVEL_STATES, v.rows, v.numRows);
+        }
+        top().begin();
+        top().start(mLevels[0].states[0]);
+    }
+
+    ~BenchHierarchy() {
+        top().stop();
+        for (unsigned int l = 0; l <= mDepth; l++) {
+            for (smIndex_t s = 0; s < BENCH_LEVEL_STATES; s++) {
+                delete mLevels[l].states[s];
+            }
+        }
+        for (unsigned int l = mDepth + 1; l-- > 0;) {
+            delete mLevels[l].machine;
+            delete mLevels[l].submachine;
+        }
+    }
+
+    smMachine& top() { return *mLevels[0].machine; }
+    smMachine& level(unsigned int l) { return *mLevels[l].machine; }
+    smState* state(unsigned int l, smIndex_t s) { return mLevels[l].states[s]; }
+    const smTransition& row(unsigned int l, smIndex_t i) { return mLevels[l].rows[i]; }
+    smIndex_t numRows(unsigned int l) { return mLevels[l].numRows; }
+
+private:
+    struct Level {
+        BenchAction actions[BENCH_LEVEL_STATES];
+        smState* states[BENCH_LEVEL_STATES];
+        smTransition rows[BENCH_LEVEL_ROWS];
+        smIndex_t numRows;
+        smSubmachine* submachine;
+        smMachine* machine;
+    };
+
+    unsigned int mDepth;
+    Level mLevels[BENCH_MAX_DEPTH + 1];
+};
+
+// The same behaviour as one flat machine, sub-states emulated the usual
+// way: every row of a composite state copied onto each state inside it
+// (unless an inner level already takes that exit code)
+class BenchFlat {
+public:
+    BenchFlat(BenchHierarchy& h, unsigned int depth) : mNumStates(0), mNumRows(0) {
+        // Flat state per non-composite state: levels' states 1.., leaf's 0..
+        smIndex_t map[BENCH_MAX_DEPTH + 1][BENCH_LEVEL_STATES];
+        for (unsigned int l = 0; l <= depth; l++) {
+            for (smIndex_t s = 0; s < BENCH_LEVEL_STATES; s++) {
+                if (s > 0 || l == depth) {
+                    map[l][s] = mNumStates;
+                    mStates[mNumStates] = new smState(&mActions[mNumStates], "BENCH", TASK_HOUR);
+                    mNumStates++;
+                }
+            }
+        }
+        // Entering a composite state enters the leaf's state 0
+        for (unsigned int l = 0; l < depth; l++) {
+            map[l][0] = map[depth][0];
+        }
+        mEntry = map[depth][0];
+
+        for (unsigned int l = 0; l <= depth; l++) {
+            for (smIndex_t s = 0; s < BENCH_LEVEL_STATES; s++) {
+                if (s == 0 && l < depth) {
+                    continue;
+                }
+                // Rows of this state, then of each enclosing composite state
+                // for codes not taken further in
+                smIndex_t first = mNumRows;
+                for (unsigned int a = l + 1; a-- > 0;) {
+                    smState* from = a == l ? h.state(l, s) : h.state(a, 0);
+                    for (smIndex_t i = 0; i < h.numRows(a); i++) {
+                        const smTransition& t = h.row(a, i);
+                        if (t.fromState != from || taken(first, t.exitCondition)) {
+                            continue;
+                        }
+                        smIndex_t to = SM_NO_INDEX;
+                        for (smIndex_t k = 0; k < BENCH_LEVEL_STATES; k++) {
+                            if (h.state(a, k) == t.toState) {
+                                to = map[a][k];
+                            }
+                        }
+                        mRows[mNumRows++] = { mStates[map[l][s]], t.exitCondition, mStates[to] };
+                    }
+                }
+            }
+        }
+        mMachine = new smMachine(mStates, mNumStates, mRows, mNumRows);
+        mMachine->begin();
+        mMachine->start(mStates[mEntry]);
+    }
+
+    ~BenchFlat() {
+        mMachine->stop();
+        for (smIndex_t s = 0; s < mNumStates; s++) {
+            delete mStates[s];
+        }
+        delete mMachine;
+    }
+
+    smMachine& machine() { return *mMachine; }
+    smIndex_t numRows() { return mNumRows; }
+
+private:
+    bool taken(smIndex_t first, smExitCode_t code) {
+        for (smIndex_t i = first; i < mNumRows; i++) {
+            if (mRows[i].exitCondition == code) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static const unsigned int kMaxStates = (BENCH_MAX_DEPTH + 1) * BENCH_LEVEL_STATES;
+    BenchAction mActions[kMaxStates];
+    smState* mStates[kMaxStates];
+    smTransition mRows[kMaxStates * (BENCH_MAX_DEPTH + 1) * BENCH_LEVEL_ROWS];
+    smIndex_t mNumStates;
+    smIndex_t mNumRows;
+    smIndex_t mEntry;
+    smMachine* mMachine;
+};
+
+static void benchHierarchy(unsigned int depth) {
+    char param[32];
+    snprintf(param, sizeof(param), "depth=%u", depth);
+    BenchHierarchy h(depth);
+    BenchFlat flat(h, depth);
+    smMachine& leaf = h.level(depth);
+
+    // Table size: rows and bytes (rows, index and bubble tables)
+    size_t rows = 0;
+    size_t bytes = 0;
+    for (unsigned int l = 0; l <= depth; l++) {
+        rows += h.numRows(l);
+        bytes += h.numRows(l) * sizeof(smTransition) + h.level(l).getIndexSize();
+    }
+    benchReport("hierarchy", param, (double)rows, "rows nested");
+    benchReport("hierarchy", param, (double)flat.numRows(), "rows copied");
+    benchReport("hierarchy", param, (double)bytes, "table bytes nested");
+    benchReport("hierarchy", param,
+                (double)(flat.numRows() * sizeof(smTransition) + flat.machine().getIndexSize()),
+                "table bytes copied");
+
+    // An exit code no level takes: the leaf's lookup and one bubble table
+    // search, against asking every level's table in turn
+    const smExitCode_t unknown = (smExitCode_t)(EXIT_USER + 100);
+    double bubbled = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            leaf.requestTransition(unknown);
+        }
+    }, 1u << 18);
+    benchReport("hierarchy", param, bubbled, "ns/unresolved exit flattened");
+    double walked = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            for (unsigned int l = depth + 1; l-- > 0;) {
+                smMachine& m = h.level(l);
+                benchKeep(m.findNextState(m.getCurrentState(), unknown));
+            }
+        }
+    }, 1u << 18);
+    benchReport("hierarchy", param, walked, "ns/unresolved exit walking levels");
+
+    // Leave from the leaf on a top-level row and come back: nested (every
+    // child stopped and restarted) against the copied-row machine
+    const smExitCode_t escape = benchEscape(0, 0);
+    double nested = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            leaf.requestTransition(escape);
+            h.top().requestTransition(escape);
+        }
+    }, 1u << 16);
+    benchReport("hierarchy", param, nested / 2, "ns/transition nested");
+    double copied = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            flat.machine().requestTransition(escape);
+            flat.machine().requestTransition(escape);
+        }
+    }, 1u << 16);
+    benchReport("hierarchy", param, copied / 2, "ns/transition copied");
+}
+
+SM_BENCH(hierarchy) {
+    for (unsigned int depth = 1; depth <= BENCH_MAX_DEPTH; depth++) {
+        benchHierarchy(depth);
+    }
+}
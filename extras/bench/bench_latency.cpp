@@ -0,0 +1,70 @@
+// =============================================================================
+// bench_latency.cpp - requestExit() to onEnter() latency (SM_LATENCY_HISTOGRAM)
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+#ifdef SM_LATENCY_HISTOGRAM
+
+// Exits on every run and spends `mExitUs` in onExit()
+class BenchSlowExitAction : public BenchAction {
+public:
+    BenchSlowExitAction() : mExitUs(0) {}
+
+    void onExit() override {
+        if (mExitUs) {
+            delayMicroseconds(mExitUs);
+        }
+    }
+
+    unsigned int mExitUs;
+};
+
+// Two states bouncing on EXIT_USER; reports the machine-wide p50/p99/max
+// in microseconds after `transitions` transitions
+static void benchLatency(unsigned int exitUs, bool runToCompletion) {
+    BenchSlowExitAction actions[2];
+    smState a(&actions[0], "A", TASK_IMMEDIATE);
+    smState b(&actions[1], "B", TASK_IMMEDIATE);
+    smState* states[] = { &a, &b };
+    smTransition rows[] = {
+        { &a, EXIT_USER, &b },
+        { &b, EXIT_USER, &a },
+    };
+    for (int i = 0; i < 2; i++) {
+        actions[i].mExitOnRun = EXIT_USER;
+        actions[i].mExitUs = exitUs;
+    }
+    smMachine m(states, 2, rows, 2);
+    m.setRunToCompletion(runToCompletion);
+    m.begin();
+    m.start(&a);
+
+    const unsigned long transitions = 20000;
+    while (m.getTransitionCount() < transitions) {
+        m.execute();
+    }
+    smHistogram h, row;
+    m.getLatency(h);
+    m.getLatency(0, row);
+    m.stop();
+
+    char param[64];
+    snprintf(param, sizeof(param), "onExit=%uus,mode=%s", exitUs, runToCompletion ? "rtc" : "direct");
+    benchReport("latency", param, (double)h.getPercentile(50), "us p50");
+    benchReport("latency", param, (double)h.getPercentile(99), "us p99");
+    benchReport("latency", param, (double)h.getMax(), "us max");
+    benchReport("latency", param, (double)row.getCount() / h.getCount() * 100.0, "% on row 0");
+}
+
+SM_BENCH(latency) {
+    benchLatency(0, false);
+    benchLatency(0, true);
+    benchLatency(20, false);
+    benchLatency(20, true);
+}
+
+#endif
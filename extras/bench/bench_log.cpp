@@ -0,0 +1,230 @@
+// =============================================================================
+// bench_log.cpp - smLog deferred logging against direct Serial printing
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// UART that discards its output: with a baud rate, write() blocks once the
+// 128-byte TX FIFO is full, like HardwareSerial at that rate
+class BenchUart : public Print {
+public:
+    BenchUart(unsigned long baud) : mByteUs(baud ? 10000000UL / baud : 0), mFree(128), mLast(micros()), mBytes(0) {}
+
+    size_t write(uint8_t c) override {
+        if (mByteUs) {
+            while (!drain()) {}
+            mFree--;
+        }
+        benchKeep(c);
+        mBytes++;
+        return 1;
+    }
+
+    int availableForWrite() override { return mByteUs ? (int)drain() : 128; }
+
+    // FIFO space after the bytes sent since the last call
+    unsigned long drain() {
+        unsigned long now = micros();
+        unsigned long drained = (now - mLast) / mByteUs;
+        if (drained) {
+            mFree = mFree + drained > 128 ? 128 : mFree + drained;
+            mLast = mFree == 128 ? now : mLast + drained * mByteUs;
+        }
+        return mFree;
+    }
+
+    unsigned long mByteUs;
+    unsigned long mFree;
+    unsigned long mLast;
+    unsigned long mBytes;
+};
+
+static const char* const benchLogFormats[] = {
+    ">> Entering %S",
+    "<< Exiting %S (%E)",
+};
+
+static const char* benchExitName(smExitCode_t code) {
+    switch (code) {
+        case EXIT_COMPLETE: return "COMPLETE";
+        case EXIT_USER:     return "USER";
+        default:            return "UNKNOWN";
+    }
+}
+
+// Logs entry and exit the LedActions.cpp way (direct) or through smLog,
+// exits `mPeriod` ms after entry, and times onExit() to the end of the
+// next state's onEnter()
+class BenchLogAction : public smAction {
+public:
+    BenchLogAction()
+        : smAction(nullptr, "LOG"), mLog(nullptr), mOut(nullptr), mExitStart(nullptr), mPeriod(0)
+        , mEntered(0), mMaxUs(0), mTotalUs(0), mCount(0) {}
+
+    bool onRun() override {
+        if (millis() - mEntered >= mPeriod) {
+            requestExit(EXIT_USER);
+        }
+        return true;
+    }
+
+    void onEnter() override {
+        mEntered = millis();
+        smState* state = getMachine()->getCurrentState();
+        if (mLog) {
+            mLog->write(0, state->getIndex());
+        } else {
+            mOut->print(">> Entering ");
+            mOut->println(state->getName());
+        }
+        if (*mExitStart) {
+            unsigned long us = micros() - *mExitStart;
+            mMaxUs = us > mMaxUs ? us : mMaxUs;
+            mTotalUs += us;
+            mCount++;
+        }
+    }
+
+    void onExit() override {
+        *mExitStart = micros();
+        smState* state = getMachine()->getCurrentState();
+        if (mLog) {
+            mLog->write(1, state->getIndex(), getExitCode());
+        } else {
+            mOut->print("<< Exiting ");
+            mOut->print(state->getName());
+            mOut->print(" (");
+            mOut->print(benchExitName(getExitCode()));
+            mOut->println(")");
+        }
+    }
+
+    smLog* mLog;
+    Print* mOut;
+    unsigned long* mExitStart;
+    unsigned long mPeriod;
+    unsigned long mEntered;
+    unsigned long mMaxUs;
+    unsigned long mTotalUs;
+    unsigned long mCount;
+};
+
+// Two states bouncing every `period` ms for 500 ms, logging at 115200 baud
+// (about 11.5 bytes/ms); at 2 ms the text log outruns the UART
+static void benchLogMachine(const char* mode, unsigned long period, bool deferred, bool binary,
+                            bool nonBlocking) {
+    BenchUart uart(115200);
+    smLog log(uart);
+    log.setFormats(benchLogFormats, 2);
+    log.setBinary(binary);
+    log.setNonBlocking(nonBlocking);
+
+    BenchLogAction actions[2];
+    smState a(&actions[0], "STATE_A");
+    smState b(&actions[1], "STATE_B");
+    smState* states[] = { &a, &b };
+    smTransition rows[] = {
+        { &a, EXIT_USER, &b },
+        { &b, EXIT_USER, &a },
+    };
+    unsigned long exitStart = 0;
+    for (int i = 0; i < 2; i++) {
+        actions[i].mPeriod = period;
+        actions[i].mLog = deferred ? &log : nullptr;
+        actions[i].mOut = &uart;
+        actions[i].mExitStart = &exitStart;
+    }
+    log.setStates(states, 2);
+
+    smMachine m(states, 2, rows, 2);
+    m.begin();
+    if (deferred) {
+        m.getScheduler().addTask(log);
+        log.enable();
+    }
+    m.start(&a);
+    unsigned long start = millis();
+    while (millis() - start < 500) {
+        m.execute();
+    }
+    m.stop();
+    log.disable();
+
+    unsigned long maxUs = 0, totalUs = 0, count = 0;
+    for (int i = 0; i < 2; i++) {
+        maxUs = actions[i].mMaxUs > maxUs ? actions[i].mMaxUs : maxUs;
+        totalUs += actions[i].mTotalUs;
+        count += actions[i].mCount;
+    }
+    char param[64];
+    snprintf(param, sizeof(param), "mode=%s,period=%lums", mode, period);
+    benchReport("log", param, count ? (double)totalUs / count : 0.0, "us/transition");
+    benchReport("log", param, (double)maxUs, "us max transition");
+    benchReport("log", param, (double)count * 2, "transitions/s");
+    benchReport("log", param, (double)uart.mBytes / count, "bytes/transition");
+    if (deferred) {
+        benchReport("log", param, (double)log.getDropped(), "dropped");
+    }
+}
+
+SM_BENCH(log) {
+    // Per-record cost in the caller: direct print (no baud limit, so
+    // formatting only) against smLog::write()
+    BenchUart fast(0);
+    double direct = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            fast.print("<< Exiting ");
+            fast.print("STATE_BLINK");
+            fast.print(" (");
+            fast.print(benchExitName(EXIT_USER));
+            fast.println(")");
+        }
+    }, 1u << 16);
+    benchReport("log", "record=print", direct, "ns/record");
+
+    smLog log(fast);
+    log.setFormats(benchLogFormats, 2);
+    double write = 0;
+    for (int r = 0; r < 5; r++) {
+        // Time full queues' worth of writes, draining outside the timing
+        uint64_t ns = 0;
+        uint32_t n = 0;
+        while (n < (1u << 16)) {
+            uint64_t t0 = benchNowNs();
+            for (unsigned int i = 0; i < smLog::capacity(); i++) {
+                log.write(1, 2, EXIT_USER);
+            }
+            ns += benchNowNs() - t0;
+            n += smLog::capacity();
+            log.flush();
+        }
+        double each = (double)ns / n;
+        write = (r == 0 || each < write) ? each : write;
+    }
+    benchReport("log", "record=smLog::write", write, "ns/record");
+
+    // Deferred cost per record, paid in the drain task
+    for (int binary = 0; binary < 2; binary++) {
+        log.setBinary(binary);
+        double drain = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i += smLog::capacity()) {
+                for (unsigned int k = 0; k < smLog::capacity(); k++) {
+                    log.write(1, 2, EXIT_USER);
+                }
+                log.flush();
+            }
+        }, 1u << 16);
+        benchReport("log", binary ? "drain=binary" : "drain=text", drain - write, "ns/record");
+    }
+
+    const unsigned long periods[] = { 10, 2 };
+    for (unsigned long period : periods) {
+        benchLogMachine("direct", period, false, false, false);
+        benchLogMachine("smLog_text_blocking", period, true, false, false);
+        benchLogMachine("smLog_text", period, true, false, true);
+        benchLogMachine("smLog_binary", period, true, true, true);
+    }
+}
@@ -0,0 +1,54 @@
+// =============================================================================
+// bench_main.cpp - Runs the registered benchmarks
+// =============================================================================
+// Usage: sm_bench [filter]
+//   Runs every benchmark whose name contains <filter> (all if omitted).
+// =============================================================================
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static smBenchEntry* sFirst = nullptr;
+static smBenchEntry* sLast = nullptr;
+
+smBenchRegister::smBenchRegister(const char* name, smBenchFn fn) {
+    static smBenchEntry entries[64];
+    static size_t count = 0;
+    if (count < sizeof(entries) / sizeof(entries[0])) {
+        smBenchEntry* e = &entries[count++];
+        e->name = name;
+        e->fn = fn;
+        e->next = nullptr;
+        if (sLast) {
+            sLast->next = e;
+        } else {
+            sFirst = e;
+        }
+        sLast = e;
+    }
+}
+
+uint64_t benchNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void benchReport(const char* bench, const char* param, double value, const char* unit) {
+    printf("{\"bench\":\"%s\",\"config\":\"%s\",\"param\":\"%s\",\"value\":%.3f,\"unit\":\"%s\"}\n",
+           bench, SM_BENCH_CONFIG, param, value, unit);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    for (smBenchEntry* e = sFirst; e; e = e->next) {
+        if (!filter || strstr(e->name, filter)) {
+            e->fn();
+        }
+    }
+    return 0;
+}
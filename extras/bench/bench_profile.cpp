@@ -0,0 +1,27 @@
+// =============================================================================
+// bench_profile.cpp - Per-state profiler (SM_PROFILING builds)
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#ifdef SM_PROFILING
+
+// Cost of taking a snapshot (the profiled Callback() cost shows up in the
+// dispatch benchmark of this build)
+SM_BENCH(profile) {
+    BenchMachine bm(2, 1);
+    smMachine& m = bm.machine();
+
+    smStateStats stats;
+    double snapshot = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.getStateStats(0, stats);
+            benchKeep(stats.runCount);
+        }
+    }, 1u << 20);
+
+    benchReport("profile", "getStateStats", snapshot, "ns/call");
+}
+
+#endif
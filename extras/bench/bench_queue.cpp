@@ -0,0 +1,53 @@
+// =============================================================================
+// bench_queue.cpp - Posted transition (event queue) costs
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#if SM_EVENT_QUEUE_SIZE > 0
+
+// postTransition() cost, and the cost of applying a posted transition from
+// execute() compared with a direct requestTransition()
+SM_BENCH(queue) {
+    BenchMachine bm(2, 1, TASK_HOUR);
+    smMachine& m = bm.machine();
+
+    // Push/pop pairs on an otherwise idle queue
+    smQueue<uint8_t, SM_EVENT_QUEUE_SIZE> q;
+    uint8_t item = 0;
+    double push = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            q.push((uint8_t)i);
+            q.pop(item);
+            benchKeep(item);
+        }
+    }, 1u << 22);
+    benchReport("queue", "push+pop", push, "ns/item");
+
+    m.start(bm.state(0));
+    m.execute();
+    double direct = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.requestTransition(EXIT_USER);
+        }
+    }, 1u << 18);
+    double posted = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.postTransition(EXIT_USER);
+            m.execute();
+        }
+    }, 1u << 18);
+    double idle = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.execute();
+        }
+    }, 1u << 18);
+    m.stop();
+
+    benchReport("queue", "requestTransition", direct, "ns/transition");
+    benchReport("queue", "postTransition+execute", posted - idle, "ns/transition");
+    benchReport("queue", "overflows", (double)m.getQueueOverflowCount(), "count");
+}
+
+#endif
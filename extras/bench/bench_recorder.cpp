@@ -0,0 +1,39 @@
+// =============================================================================
+// bench_recorder.cpp - Flight recorder (SM_FLIGHT_RECORDER_SIZE builds)
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#if SM_FLIGHT_RECORDER_SIZE > 0
+
+// A Print that only counts, so dump() cost excludes any real output
+class BenchNullPrint : public Print {
+public:
+    size_t write(uint8_t c) override { benchKeep(c); return 1; }
+};
+
+// Cost of one record (the per-transition overhead) and of a full dump
+SM_BENCH(recorder) {
+    BenchMachine bm(4, 1);
+    smFlightRecorder& r = bm.machine().getRecorder();
+
+    double record = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            r.record((uint8_t)i & 3, EXIT_USER, (uint8_t)(i + 1) & 3, 0);
+        }
+    }, 1u << 20);
+    benchReport("recorder", "record", record, "ns/transition");
+
+    BenchNullPrint out;
+    size_t bytes = 0;
+    double dump = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            bytes = r.dump(out);
+        }
+    }, 1u << 10);
+    benchReport("recorder", "dump", dump, "ns/dump");
+    benchReport("recorder", "dump_size", (double)bytes, "bytes");
+}
+
+#endif
@@ -0,0 +1,77 @@
+// =============================================================================
+// bench_regions.cpp - Orthogonal regions against machines sharing a scheduler
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// Per-tick cost with no state due: one machine with `regions` regions of
+// `states` states each, against as many machines on a shared scheduler
+// (every state in the task chain). Also the cost of a broadcast() every
+// region takes.
+static void benchRegions(unsigned int regions, smIndex_t states) {
+    char param[48];
+
+    BenchMachine** parts = new BenchMachine*[regions + 1];
+    parts[0] = new BenchMachine(states, 1, TASK_HOUR, nullptr, false);
+    smMachine& parent = parts[0]->machine();
+    for (unsigned int i = 1; i <= regions; i++) {
+        parts[i] = new BenchMachine(states, 1, TASK_HOUR, nullptr, false);
+        parent.addRegion(parts[i]->machine(), parts[i]->state(0));
+    }
+    parent.begin();
+    parent.start(parts[0]->state(0));
+    parent.execute();  // first run happens immediately after enable()
+    double ns = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            parent.execute();
+        }
+    }, 20000);
+    snprintf(param, sizeof(param), "regions=%u,states=%u,mode=regions", regions, (unsigned)states);
+    benchReport("regions", param, ns, "ns/tick");
+
+    // Every region steps on EXIT_USER
+    double broadcastNs = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            parent.broadcast(EXIT_USER);
+        }
+    }, 20000);
+    benchReport("regions", param, broadcastNs / (regions + 1), "ns/region broadcast");
+    parent.stop();
+    for (unsigned int i = regions + 1; i-- > 0;) {
+        delete parts[i];
+    }
+
+    Scheduler shared;
+    smMachineGroup group(&shared);
+    for (unsigned int i = 0; i <= regions; i++) {
+        parts[i] = new BenchMachine(states, 1, TASK_HOUR, &shared);
+        group.add(parts[i]->machine());
+        parts[i]->machine().start(parts[i]->state(0));
+    }
+    group.execute();
+    ns = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            group.execute();
+        }
+    }, 20000);
+    snprintf(param, sizeof(param), "regions=%u,states=%u,mode=machines", regions, (unsigned)states);
+    benchReport("regions", param, ns, "ns/tick");
+    for (unsigned int i = regions + 1; i-- > 0;) {
+        delete parts[i];
+    }
+    delete[] parts;
+}
+
+SM_BENCH(regions) {
+    const smIndex_t states[] = { 4, 32, 128 };
+    for (smIndex_t s : states) {
+        benchRegions(3, s);
+    }
+    const unsigned int regions[] = { 1, 7, 15 };
+    for (unsigned int r : regions) {
+        benchRegions(r, 16);
+    }
+}
@@ -0,0 +1,67 @@
+// =============================================================================
+// bench_snapshot.cpp - Wake-to-running latency: cold start against restore
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// Five start-up states (each exits on its first run) lead to RUN. A cold
+// wake runs begin() and start() and steps through the start-up states; a
+// warm wake runs begin() and restoreSnapshot() straight into RUN. Only
+// framework time is measured: real start-up states add their device time
+// to the cold path.
+SM_BENCH(snapshot) {
+    const smIndex_t numStates = 6;
+    const smIndex_t run = numStates - 1;
+    BenchAction actions[numStates];
+    smState* states[numStates];
+    smTransition rows[numStates - 1];
+    for (smIndex_t s = 0; s < numStates; s++) {
+        states[s] = new smState(&actions[s], "BENCH", s == run ? TASK_HOUR : TASK_IMMEDIATE);
+    }
+    for (smIndex_t s = 0; s < run; s++) {
+        actions[s].mExitOnRun = EXIT_COMPLETE;
+        rows[s] = { states[s], EXIT_COMPLETE, states[s + 1] };
+    }
+    smMachine* m = new smMachine(states, numStates, rows, numStates - 1);
+
+    double cold = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m->stop();
+            m->begin();
+            m->start(states[0]);
+            while (m->getCurrentState() != states[run]) {
+                m->execute();
+            }
+        }
+    }, 1u << 14);
+    benchReport("snapshot", "wake=cold,startup-states=5", cold, "ns/wake");
+
+    uint8_t blob[SM_SNAPSHOT_SIZE(0)];
+    size_t size = 0;
+    double save = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            size = m->saveSnapshot(blob, sizeof(blob));
+            benchKeep(blob);
+        }
+    }, 1u << 16);
+    benchReport("snapshot", "save", save, "ns/save");
+    benchReport("snapshot", "save", (double)size, "bytes");
+
+    double warm = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m->stop();
+            m->begin();
+            m->restoreSnapshot(blob, size);
+        }
+    }, 1u << 14);
+    benchReport("snapshot", "wake=restore", warm, "ns/wake");
+
+    m->stop();
+    for (smIndex_t s = 0; s < numStates; s++) {
+        delete states[s];
+    }
+    delete m;
+}
@@ -0,0 +1,135 @@
+// =============================================================================
+// bench_startup.cpp - Boot time with slow devices: blocking against polled,
+// and shared devices begun per action, once, or lazily
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// Device with a fixed warm-up, either waited out inside begin() (the
+// classic blocking driver) or reported as smSTARTING and polled
+class BenchSlowDevice : public smDevice {
+public:
+    BenchSlowDevice(unsigned long warmup, bool polled) : mWarmup(warmup), mPolled(polled), mBegin(0) {}
+
+    bool begin() override {
+        if (!mPolled) {
+            delay(mWarmup);
+            return true;
+        }
+        mBegin = millis();
+        setState(smSTARTING);
+        return true;
+    }
+    bool poll() override {
+        if (millis() - mBegin >= mWarmup) {
+            setState(smOFF);
+        }
+        return true;
+    }
+    bool start() override { return true; }
+    void stop() override {}
+    void end() override {}
+
+private:
+    unsigned long mWarmup;
+    bool mPolled;
+    unsigned long mBegin;
+};
+
+class BenchDeviceAction : public smAction {
+public:
+    BenchDeviceAction(smDevice* device) : smAction(device, "BENCH") {}
+    bool onRun() override { return true; }
+};
+
+// Four devices warming up for 10, 20, 30 and 40 ms; time from begin() to
+// the machine running
+static void benchStartup(const char* mode, bool polled, bool async) {
+    const int numDevices = 4;
+    BenchSlowDevice* devices[numDevices];
+    BenchDeviceAction* actions[numDevices];
+    smState* states[numDevices];
+    for (int i = 0; i < numDevices; i++) {
+        devices[i] = new BenchSlowDevice(10 * (i + 1), polled);
+        actions[i] = new BenchDeviceAction(devices[i]);
+        states[i] = new smState(actions[i], "BENCH", TASK_HOUR);
+    }
+    smMachine* m = new smMachine(states, numDevices, nullptr, 0);
+    smMachineGroup group;
+    group.add(*m);
+    m->setAsyncStartup(async);
+
+    uint64_t t0 = benchNowNs();
+    m->begin();
+    m->start(states[0]);
+    while (!m->isRunning()) {
+        group.execute();
+    }
+    double ms = (double)(benchNowNs() - t0) / 1e6;
+
+    char param[64];
+    snprintf(param, sizeof(param), "devices=4,warmup=10..40ms,mode=%s", mode);
+    benchReport("startup", param, ms, "ms");
+
+    m->stop();
+    for (int i = 0; i < numDevices; i++) {
+        delete states[i];
+        delete actions[i];
+        delete devices[i];
+    }
+    delete m;
+}
+
+// Action that begins its device directly, as before shared lifecycles
+class BenchUnsharedAction : public smAction {
+public:
+    BenchUnsharedAction(smDevice* device) : smAction(device, "BENCH") {}
+    bool begin() override { return mDevice->begin(); }
+    void end() override { mDevice->end(); }
+    bool onRun() override { return true; }
+};
+
+// Four actions sharing one device with a 10 ms begin(); time spent in
+// the machine's begin()
+static void benchSharedStartup(const char* mode) {
+    const int numActions = 4;
+    BenchSlowDevice device(10, false);
+    device.setLazy(mode[0] == 'l');
+    smAction* actions[numActions];
+    smState* states[numActions];
+    for (int i = 0; i < numActions; i++) {
+        if (mode[0] == 'p') {
+            actions[i] = new BenchUnsharedAction(&device);
+        } else {
+            actions[i] = new BenchDeviceAction(&device);
+        }
+        states[i] = new smState(actions[i], "BENCH", TASK_HOUR);
+    }
+    smMachine* m = new smMachine(states, numActions, nullptr, 0);
+
+    uint64_t t0 = benchNowNs();
+    m->begin();
+    double ms = (double)(benchNowNs() - t0) / 1e6;
+
+    char param[64];
+    snprintf(param, sizeof(param), "actions=4,shared-device=10ms,mode=%s", mode);
+    benchReport("startup", param, ms, "ms");
+
+    for (int i = 0; i < numActions; i++) {
+        delete states[i];
+        delete actions[i];
+    }
+    delete m;
+}
+
+SM_BENCH(startup) {
+    benchStartup("blocking", false, false);
+    benchStartup("polled", true, false);
+    benchStartup("async", true, true);
+    benchSharedStartup("per-action");
+    benchSharedStartup("shared");
+    benchSharedStartup("lazy");
+}
@@ -0,0 +1,72 @@
+// =============================================================================
+// bench_static.cpp - smStaticMachine lookup against the runtime table
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+BenchAction sActions[8];
+smState S0(&sActions[0]), S1(&sActions[1]), S2(&sActions[2]), S3(&sActions[3]),
+        S4(&sActions[4]), S5(&sActions[5]), S6(&sActions[6]), S7(&sActions[7]);
+smState* sStates[] = { &S0, &S1, &S2, &S3, &S4, &S5, &S6, &S7 };
+
+#define BENCH_ROWS(ROW) \
+    ROW(S0, 0, S1) ROW(S0, 1, S2) ROW(S1, 0, S2) ROW(S1, 1, S3) \
+    ROW(S2, 0, S3) ROW(S2, 1, S4) ROW(S3, 0, S4) ROW(S3, 1, S5) \
+    ROW(S4, 0, S5) ROW(S4, 1, S6) ROW(S5, 0, S6) ROW(S5, 1, S7) \
+    ROW(S6, 0, S7) ROW(S6, 1, S0) ROW(S7, 0, S0) ROW(S7, 1, S1)
+
+#define RUNTIME_ROW(f, k, t) { &f, EXIT_USER + k, &t },
+smTransition sTransitions[] = { BENCH_ROWS(RUNTIME_ROW) };
+
+typedef smStaticMachine<
+    smRow<&S0, EXIT_USER + 0, &S1>, smRow<&S0, EXIT_USER + 1, &S2>,
+    smRow<&S1, EXIT_USER + 0, &S2>, smRow<&S1, EXIT_USER + 1, &S3>,
+    smRow<&S2, EXIT_USER + 0, &S3>, smRow<&S2, EXIT_USER + 1, &S4>,
+    smRow<&S3, EXIT_USER + 0, &S4>, smRow<&S3, EXIT_USER + 1, &S5>,
+    smRow<&S4, EXIT_USER + 0, &S5>, smRow<&S4, EXIT_USER + 1, &S6>,
+    smRow<&S5, EXIT_USER + 0, &S6>, smRow<&S5, EXIT_USER + 1, &S7>,
+    smRow<&S6, EXIT_USER + 0, &S7>, smRow<&S6, EXIT_USER + 1, &S0>,
+    smRow<&S7, EXIT_USER + 0, &S0>, smRow<&S7, EXIT_USER + 1, &S1>
+> BenchStaticMachine;
+
+}  // namespace
+
+SM_BENCH(static_lookup) {
+    smMachine runtime(sStates, 8, sTransitions, 16);
+    runtime.begin();
+    BenchStaticMachine fixed(sStates, 8);
+
+    const uint32_t numQueries = 4096;
+    static uint8_t qState[numQueries];
+    static uint8_t qCode[numQueries];
+    srand(1);
+    for (uint32_t i = 0; i < numQueries; i++) {
+        qState[i] = (uint8_t)(rand() % 8);
+        qCode[i] = (uint8_t)(EXIT_USER + rand() % 2);
+    }
+
+    double dyn = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            uint32_t q = i & (numQueries - 1);
+            benchKeep(runtime.findNextState(sStates[qState[q]], qCode[q]));
+        }
+    }, 1u << 20);
+    double fix = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            uint32_t q = i & (numQueries - 1);
+            benchKeep(fixed.findNextState(sStates[qState[q]], qCode[q]));
+        }
+    }, 1u << 20);
+
+    char param[48];
+    snprintf(param, sizeof(param), "rows=16,table=runtime,bytes=%u",
+             (unsigned)(sizeof(sTransitions) + runtime.getIndexSize()));
+    benchReport("static_lookup", param, dyn, "ns/lookup");
+    benchReport("static_lookup", "rows=16,table=static,bytes=0", fix, "ns/lookup");
+}
@@ -0,0 +1,117 @@
+// =============================================================================
+// bench_tickless.cpp - Event-driven and adaptive states against 1 ms polling
+// =============================================================================
+
+#include "bench.h"
+
+#include "StateMachine.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t benchCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// LED-style action: waits for a "button press" and then switches state
+class BenchButtonAction : public smAction {
+public:
+    BenchButtonAction() : smAction(nullptr, "BUTTON"), mRuns(0) {}
+
+    bool onRun() override {
+        mRuns++;
+        if (sPressed) {
+            sPressed = false;
+            sLatency += micros() - sPressTime;
+            sPresses++;
+            requestExit(EXIT_USER);
+            return true;
+        }
+        return false;
+    }
+
+    static bool sPressed;
+    static unsigned long sPressTime;
+    static unsigned long sLatency;
+    static unsigned long sPresses;
+    unsigned long mRuns;
+};
+
+bool BenchButtonAction::sPressed = false;
+unsigned long BenchButtonAction::sPressTime = 0;
+unsigned long BenchButtonAction::sLatency = 0;
+unsigned long BenchButtonAction::sPresses = 0;
+
+// Two states toggling on presses arriving every 50 ms; the loop sleeps for
+// whatever execute() reports (or spins, as the library's loop() does by
+// default, when `sleep` is false). A non-zero `maxInterval` makes the states
+// adaptive (1..maxInterval ms); with `signal` false the press is a level the
+// action has to poll for, so the reaction latency shows the cost of backing off
+static void benchTickless(const char* mode, bool eventDriven, bool sleep,
+                          unsigned long maxInterval = 0, bool signal = true) {
+    BenchButtonAction off, on;
+    smState offState(&off, "OFF");
+    smState onState(&on, "ON");
+    offState.setEventDriven(eventDriven);
+    onState.setEventDriven(eventDriven);
+    if (maxInterval) {
+        offState.setAdaptiveInterval(SM_DEFAULT_INTERVAL_MS, maxInterval);
+        onState.setAdaptiveInterval(SM_DEFAULT_INTERVAL_MS, maxInterval);
+    }
+    BenchButtonAction::sPressed = false;
+    BenchButtonAction::sLatency = 0;
+    BenchButtonAction::sPresses = 0;
+    smState* states[] = { &offState, &onState };
+    smTransition transitions[] = {
+        { &offState, EXIT_USER, &onState },
+        { &onState, EXIT_USER, &offState },
+    };
+    smMachine m(states, 2, transitions, 2);
+    m.begin();
+    m.start(&offState);
+
+    const unsigned long duration = 500;     // ms
+    const unsigned long pressEvery = 50;    // ms
+    unsigned long start = millis();
+    unsigned long nextPress = start + pressEvery;
+    uint64_t cpu0 = benchCpuNs();
+    unsigned long now;
+    while ((now = millis()) - start < duration) {
+        if ((long)(now - nextPress) >= 0) {
+            BenchButtonAction::sPressed = true;
+            BenchButtonAction::sPressTime = micros();
+            if (signal) {
+                m.signal();
+            }
+            nextPress += pressEvery;
+        }
+        unsigned long idle = m.execute();
+        if (sleep) {
+            unsigned long untilPress = nextPress - millis();
+            delay(idle < untilPress ? idle : untilPress);
+        }
+    }
+    uint64_t cpu = benchCpuNs() - cpu0;
+    unsigned long elapsed = millis() - start;
+    m.stop();
+
+    char param[48];
+    snprintf(param, sizeof(param), "mode=%s", mode);
+    benchReport("tickless", param, (double)(off.mRuns + on.mRuns) * 1000.0 / elapsed, "wakeups/s");
+    benchReport("tickless", param, (double)cpu / ((double)elapsed * 1e6) * 100.0, "%cpu");
+    if (BenchButtonAction::sPresses) {
+        benchReport("tickless", param,
+                    (double)BenchButtonAction::sLatency / BenchButtonAction::sPresses / 1000.0, "ms latency");
+    }
+}
+
+SM_BENCH(tickless) {
+    benchTickless("busy", false, false);
+    benchTickless("polling", false, true);
+    benchTickless("event", true, true);
+    benchTickless("polling-unsignaled", false, true, 0, false);
+    benchTickless("adaptive", false, true, 64);
+    benchTickless("adaptive-unsignaled", false, true, 64, false);
+}
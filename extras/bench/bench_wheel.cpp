@@ -0,0 +1,105 @@
+// =============================================================================
+// bench_wheel.cpp - smTimerWheel against TaskScheduler timeouts
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+static void benchWheelNothing(smTimer&, void*) {}
+
+// Idle pass and transition cost of n two-state machines on one scheduler,
+// every state with a (never reached) timeout: checked by the scheduler on
+// every pass, or armed on a shared wheel at entry; and without timeouts
+enum { BENCH_TIMEOUT_NONE, BENCH_TIMEOUT_TASK, BENCH_TIMEOUT_WHEEL };
+
+static void benchWheelMachines(unsigned int n, int mode) {
+    static const char* const modes[] = { "none", "task", "wheel" };
+    bool onWheel = mode == BENCH_TIMEOUT_WHEEL;
+    Scheduler shared;
+    smTimerWheel wheel;
+    BenchMachine** machines = new BenchMachine*[n];
+    for (unsigned int i = 0; i < n; i++) {
+        machines[i] = new BenchMachine(2, 1, TASK_HOUR, &shared, false);
+        for (smIndex_t s = 0; s < 2 && mode != BENCH_TIMEOUT_NONE; s++) {
+            machines[i]->state(s)->setTimeout(TASK_HOUR);
+        }
+        if (onWheel) {
+            machines[i]->machine().setTimerWheel(&wheel);
+        }
+        machines[i]->machine().begin();
+        machines[i]->machine().start(machines[i]->state(0));
+    }
+    if (onWheel) {
+        shared.addTask(wheel);
+        wheel.enable();
+    }
+    shared.execute();
+
+    char param[48];
+    snprintf(param, sizeof(param), "machines=%u,timeouts=%s", n, modes[mode]);
+    double pass = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            shared.execute();
+        }
+    }, 200000 / n + 100);
+    benchReport("wheel", param, pass, "ns/idle pass");
+
+    smMachine& m = machines[0]->machine();
+    double transition = benchBestNs([&](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            m.requestTransition(EXIT_USER);
+        }
+    }, 1u << 16);
+    benchReport("wheel", param, transition, "ns/transition");
+
+    for (unsigned int i = 0; i < n; i++) {
+        machines[i]->machine().stop();
+        delete machines[i];
+    }
+    delete[] machines;
+}
+
+SM_BENCH(wheel) {
+    const unsigned int counts[] = { 10, 100, 1000 };
+    for (unsigned int n : counts) {
+        benchWheelMachines(n, BENCH_TIMEOUT_NONE);
+        benchWheelMachines(n, BENCH_TIMEOUT_TASK);
+        benchWheelMachines(n, BENCH_TIMEOUT_WHEEL);
+    }
+
+    // Wheel operations alone, with `armed` other timers spread over a minute
+    const unsigned int loads[] = { 10, 1000, 10000 };
+    for (unsigned int armed : loads) {
+        char param[32];
+        snprintf(param, sizeof(param), "armed=%u", armed);
+        smTimerWheel wheel;
+        smTimer* others = new smTimer[armed];
+        for (unsigned int i = 0; i < armed; i++) {
+            others[i].setHandler(benchWheelNothing);
+            wheel.arm(others[i], 1000 + (i * 7919UL) % 60000);
+        }
+        smTimer timer(benchWheelNothing);
+        uint32_t k = 0;
+        double arm = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                wheel.arm(timer, 1 + (k++ * 7919UL) % 600000);
+                wheel.cancel(timer);
+            }
+        }, 1u << 18);
+        benchReport("wheel", param, arm, "ns/arm+cancel");
+
+        // Expiry: `armed` timers due within 64 ms (two levels), fired by
+        // one run; the wait is not timed
+        for (unsigned int i = 0; i < armed; i++) {
+            wheel.arm(others[i], 1 + i % 64);
+        }
+        delay(70);
+        uint64_t t0 = benchNowNs();
+        unsigned long fired = wheel.advance();
+        double ns = (double)(benchNowNs() - t0);
+        benchReport("wheel", param, fired ? ns / fired : 0.0, "ns/expiry");
+        delete[] others;
+    }
+}
@@ -0,0 +1,67 @@
+// =============================================================================
+// bench_wildcard.cpp - Wildcard rows against per-state duplicated rows
+// =============================================================================
+
+#include "bench.h"
+#include "bench_fsm.h"
+
+#include <stdio.h>
+
+// A 50-state machine: two own exits per state, plus EXIT_ERROR and
+// EXIT_ABORT to a fault state from every state, written either as one row
+// per state or as two SM_ANY_STATE rows
+static void benchWildcardTable(bool wildcards) {
+    const smIndex_t numStates = 50;
+    const smIndex_t fault = numStates - 1;
+    BenchAction actions[numStates];
+    smState* states[numStates];
+    for (smIndex_t s = 0; s < numStates; s++) {
+        states[s] = new smState(&actions[s], "BENCH", TASK_HOUR);
+    }
+
+    smTransition rows[numStates * 4];
+    smIndex_t n = 0;
+    for (smIndex_t s = 0; s < numStates; s++) {
+        rows[n++] = { states[s], EXIT_USER, states[(s + 1) % numStates] };
+        rows[n++] = { states[s], EXIT_USER + 1, states[(s + 2) % numStates] };
+        if (!wildcards) {
+            rows[n++] = { states[s], EXIT_ERROR, states[fault] };
+            rows[n++] = { states[s], EXIT_ABORT, states[fault] };
+        }
+    }
+    if (wildcards) {
+        rows[n++] = { SM_ANY_STATE, EXIT_ERROR, states[fault] };
+        rows[n++] = { SM_ANY_STATE, EXIT_ABORT, states[fault] };
+    }
+
+    smMachine* m = new smMachine(states, numStates, rows, n);
+    m->begin();
+
+    const smExitCode_t codes[] = { EXIT_USER, EXIT_ERROR };
+    const char* table = wildcards ? "wildcard" : "per-state";
+    char param[64];
+    snprintf(param, sizeof(param), "states=50,table=%s,rows=%u", table, (unsigned)n);
+    benchReport("wildcard", param, (double)(n * sizeof(smTransition)), "table-bytes");
+    benchReport("wildcard", param, (double)m->getIndexSize(), "index-bytes");
+
+    for (smExitCode_t code : codes) {
+        double ns = benchBestNs([&](uint32_t iterations) {
+            for (uint32_t i = 0; i < iterations; i++) {
+                benchKeep(m->findNextState(states[i % numStates], code));
+            }
+        }, 1u << 20);
+        snprintf(param, sizeof(param), "states=50,table=%s,code=%s", table,
+                 code == EXIT_ERROR ? "EXIT_ERROR" : "EXIT_USER");
+        benchReport("wildcard", param, ns, "ns/lookup");
+    }
+
+    for (smIndex_t s = 0; s < numStates; s++) {
+        delete states[s];
+    }
+    delete m;
+}
+
+SM_BENCH(wildcard) {
+    benchWildcardTable(false);
+    benchWildcardTable(true);
+}
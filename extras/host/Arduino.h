@@ -0,0 +1,86 @@
+#pragma once
+
+// =============================================================================
+// Arduino.h - Host (Linux) shim for building the SM framework off-target
+// =============================================================================
+// Provides just enough of the Arduino core for src/ to compile and run on a
+// desktop: millis()/micros() backed by a monotonic clock, delay(), and a
+// Print/Serial pair writing to stdout. Not for use on a device.
+//
+// Tests can hold the clock with hostClockSet(); delay() then moves the held
+// clock on instead of sleeping, until hostClockRun() resumes real time.
+// =============================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void hostClockSet(unsigned long ms);
+void hostClockRun();
+inline void yield() {}
+
+// Interrupt masking is a no-op on the host
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+    // Bytes that can be written without blocking (0 if unknown)
+    virtual int availableForWrite() { return 0; }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    HardwareSerial() : mBaud(0), mTxFree(0), mLastUs(0) {}
+
+    // A non-zero baud rate makes write() block like a real UART once the
+    // TX FIFO is full; begin(0) (the default) writes straight through
+    void begin(unsigned long baud) { mBaud = baud; mTxFree = SM_HOST_TX_FIFO; mLastUs = micros(); }
+    void end() { mBaud = 0; }
+    void flush();
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int availableForWrite() override { return mBaud ? (int)drain() : SM_HOST_TX_FIFO; }
+
+    operator bool() { return true; }
+
+    static const unsigned int SM_HOST_TX_FIFO = 128;
+
+private:
+    unsigned long drain();
+
+    unsigned long mBaud;
+    unsigned long mTxFree;
+    unsigned long mLastUs;
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host shim: the implementation lives in host.cpp, so TaskScheduler.h and
+// TaskSchedulerDeclarations.h are equivalent here.
+#include "TaskSchedulerDeclarations.h"
@@ -0,0 +1,116 @@
+#pragma once
+
+// =============================================================================
+// TaskSchedulerDeclarations.h - Host (Linux) shim of TaskScheduler
+// =============================================================================
+// A minimal, single-threaded re-implementation of the TaskScheduler API the
+// SM framework relies on, following TaskScheduler 4.x semantics for
+// _TASK_OO_CALLBACKS builds:
+//   - enable() calls OnEnable() and makes the task due immediately
+//   - disable() calls OnDisable() if the task was enabled
+//   - Callback() returning false marks the pass as idle
+//   - _TASK_TIMEOUT: enabled tasks are checked for timeout on every pass
+// Only what src/ and the host benchmarks use is provided.
+// =============================================================================
+
+#include <Arduino.h>
+
+#ifndef _TASK_OO_CALLBACKS
+#error "The host TaskScheduler shim only supports _TASK_OO_CALLBACKS"
+#endif
+
+#define TASK_IMMEDIATE      0
+#define TASK_FOREVER        (-1)
+#define TASK_ONCE           1
+#define TASK_MILLISECOND    1UL
+#define TASK_SECOND         1000UL
+#define TASK_MINUTE         60000UL
+#define TASK_HOUR           3600000UL
+#define TASK_NOTIMEOUT      0
+
+class Scheduler;
+
+class Task {
+    friend class Scheduler;
+public:
+    Task(unsigned long aInterval = 0, long aIterations = 0,
+         Scheduler* aScheduler = nullptr, bool aEnable = false);
+    virtual ~Task();
+
+    // OO callbacks
+    virtual bool Callback() = 0;
+    virtual bool OnEnable() { return true; }
+    virtual void OnDisable() {}
+
+    void enable();
+    bool enableIfNot();
+    void enableDelayed(unsigned long aDelay = 0);
+    void restart();
+    void restartDelayed(unsigned long aDelay = 0);
+    bool disable();
+    bool isEnabled() { return mEnabled; }
+
+    void delay(unsigned long aDelay = 0);
+    void forceNextIteration();
+
+    void setInterval(unsigned long aInterval);
+    unsigned long getInterval() { return mInterval; }
+    void setIterations(long aIterations) { mSetIterations = mIterations = aIterations; }
+    long getIterations() { return mIterations; }
+    unsigned long getRunCounter() { return mRunCounter; }
+    bool isFirstIteration() { return mRunCounter <= 1; }
+    bool isLastIteration() { return mIterations == 0; }
+
+#ifdef _TASK_TIMEOUT
+    void setTimeout(unsigned long aTimeout, bool aReset = false);
+    void resetTimeout();
+    unsigned long getTimeout() { return mTimeout; }
+    long untilTimeout();
+    bool timedOut() { return mTimedOut; }
+#endif
+
+    Scheduler& getScheduler() { return *mScheduler; }
+
+private:
+    bool mEnabled;
+    bool mInOnEnable;
+    unsigned long mInterval;
+    unsigned long mDelay;
+    unsigned long mPreviousMillis;
+    long mIterations;
+    long mSetIterations;
+    unsigned long mRunCounter;
+#ifdef _TASK_TIMEOUT
+    unsigned long mTimeout;
+    unsigned long mStartTime;
+    bool mTimedOut;
+#endif
+    Scheduler* mScheduler;
+    Task* mPrev;
+    Task* mNext;
+};
+
+class Scheduler {
+    friend class Task;
+public:
+    Scheduler();
+
+    void init();
+    void addTask(Task& aTask);
+    void deleteTask(Task& aTask);
+    void disableAll();
+    void enableAll();
+
+    // Run one pass over the task chain; returns true if the pass was idle
+    bool execute();
+
+    // Milliseconds until the task is due: 0 if due now, -1 if disabled
+    long timeUntilNextIteration(Task& aTask);
+
+    Task& currentTask() { return *mCurrent; }
+
+private:
+    Task* mFirst;
+    Task* mLast;
+    Task* mCurrent;
+};
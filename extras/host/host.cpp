@@ -0,0 +1,374 @@
+// =============================================================================
+// host.cpp - Host (Linux) implementation of the Arduino/TaskScheduler shim
+// =============================================================================
+
+#include <Arduino.h>
+#include <TaskSchedulerDeclarations.h>
+
+#include <stdio.h>
+#include <time.h>
+
+// === Arduino core ===
+
+static bool sHeld = false;
+static unsigned long long sHeldUs = 0;
+
+static unsigned long long hostNowUs() {
+    if (sHeld) {
+        return sHeldUs;
+    }
+    static struct timespec origin = {0, 0};
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (origin.tv_sec == 0 && origin.tv_nsec == 0) {
+        origin = ts;
+    }
+    long long ns = (long long)(ts.tv_sec - origin.tv_sec) * 1000000000LL +
+                   (long long)(ts.tv_nsec - origin.tv_nsec);
+    return (unsigned long long)ns / 1000ULL;
+}
+
+unsigned long millis() {
+    return (unsigned long)(hostNowUs() / 1000ULL);
+}
+
+unsigned long micros() {
+    return (unsigned long)hostNowUs();
+}
+
+void hostClockSet(unsigned long ms) {
+    sHeld = true;
+    sHeldUs = (unsigned long long)ms * 1000ULL;
+}
+
+void hostClockRun() {
+    sHeld = false;
+}
+
+void delay(unsigned long ms) {
+    if (sHeld) {
+        sHeldUs += (unsigned long long)ms * 1000ULL;
+        return;
+    }
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, nullptr);
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (sHeld) {
+        sHeldUs += us;
+        return;
+    }
+    unsigned long start = micros();
+    while (micros() - start < us) {}
+}
+
+// === Print ===
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(long n, int base) {
+    if (n < 0 && base == DEC) {
+        size_t len = print('-');
+        return len + print((unsigned long)(-n), base);
+    }
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    char buf[8 * sizeof(unsigned long) + 1];
+    char* p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    if (base < 2) base = DEC;
+    do {
+        unsigned long digit = n % base;
+        n /= base;
+        *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    } while (n);
+    return write(p);
+}
+
+size_t Print::print(double n, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+// === Serial ===
+
+HardwareSerial Serial;
+
+unsigned long HardwareSerial::drain() {
+    // Model a UART TX FIFO emptying at 10 bits per byte
+    const unsigned long byteUs = 10000000UL / mBaud;
+    unsigned long now = micros();
+    unsigned long drained = (now - mLastUs) / byteUs;
+    if (drained) {
+        mTxFree += drained;
+        mLastUs += drained * byteUs;
+        if (mTxFree > SM_HOST_TX_FIFO) {
+            mTxFree = SM_HOST_TX_FIFO;
+            mLastUs = now;
+        }
+    }
+    return mTxFree;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (mBaud) {
+        while (drain() == 0) {}
+        mTxFree--;
+    }
+    fputc(c, stdout);
+    return 1;
+}
+
+void HardwareSerial::flush() {
+    if (mBaud) {
+        while (drain() < SM_HOST_TX_FIFO) {}
+    }
+    fflush(stdout);
+}
+
+// === Task ===
+
+Task::Task(unsigned long aInterval, long aIterations, Scheduler* aScheduler, bool aEnable)
+    : mEnabled(false)
+    , mInOnEnable(false)
+    , mInterval(aInterval)
+    , mDelay(aInterval)
+    , mPreviousMillis(0)
+    , mIterations(aIterations)
+    , mSetIterations(aIterations)
+    , mRunCounter(0)
+#ifdef _TASK_TIMEOUT
+    , mTimeout(0)
+    , mStartTime(0)
+    , mTimedOut(false)
+#endif
+    , mScheduler(nullptr)
+    , mPrev(nullptr)
+    , mNext(nullptr)
+{
+    if (aScheduler) {
+        aScheduler->addTask(*this);
+        if (aEnable) {
+            enable();
+        }
+    }
+}
+
+Task::~Task() {
+    mEnabled = false;
+    if (mScheduler) {
+        mScheduler->deleteTask(*this);
+    }
+}
+
+void Task::enable() {
+    if (!mScheduler) {
+        return;
+    }
+    mRunCounter = 0;
+    mIterations = mSetIterations;
+    if (!mInOnEnable) {
+        Task* current = mScheduler->mCurrent;
+        mScheduler->mCurrent = this;
+        mInOnEnable = true;
+        mEnabled = OnEnable();
+        mInOnEnable = false;
+        mScheduler->mCurrent = current;
+    } else {
+        mEnabled = true;
+    }
+    mPreviousMillis = millis() - (mDelay = mInterval);
+#ifdef _TASK_TIMEOUT
+    resetTimeout();
+#endif
+}
+
+bool Task::enableIfNot() {
+    bool previous = mEnabled;
+    if (!previous) {
+        enable();
+    }
+    return previous;
+}
+
+void Task::enableDelayed(unsigned long aDelay) {
+    enable();
+    delay(aDelay);
+}
+
+void Task::restart() {
+    mIterations = mSetIterations;
+    enable();
+}
+
+void Task::restartDelayed(unsigned long aDelay) {
+    mIterations = mSetIterations;
+    enableDelayed(aDelay);
+}
+
+bool Task::disable() {
+    bool previous = mEnabled;
+    mEnabled = false;
+    mInOnEnable = false;
+    if (previous && mScheduler) {
+        Task* current = mScheduler->mCurrent;
+        mScheduler->mCurrent = this;
+        OnDisable();
+        mScheduler->mCurrent = current;
+    }
+    return previous;
+}
+
+void Task::delay(unsigned long aDelay) {
+    mDelay = aDelay ? aDelay : mInterval;
+    mPreviousMillis = millis();
+}
+
+void Task::forceNextIteration() {
+    mPreviousMillis = millis() - (mDelay = mInterval);
+}
+
+void Task::setInterval(unsigned long aInterval) {
+    mInterval = aInterval;
+    delay();
+}
+
+#ifdef _TASK_TIMEOUT
+void Task::setTimeout(unsigned long aTimeout, bool aReset) {
+    mTimeout = aTimeout;
+    if (aReset) {
+        resetTimeout();
+    }
+}
+
+void Task::resetTimeout() {
+    mStartTime = millis();
+    mTimedOut = false;
+}
+
+long Task::untilTimeout() {
+    if (mTimeout) {
+        return (long)(mTimeout - (millis() - mStartTime));
+    }
+    return -1;
+}
+#endif
+
+// === Scheduler ===
+
+Scheduler::Scheduler() : mFirst(nullptr), mLast(nullptr), mCurrent(nullptr) {
+}
+
+void Scheduler::init() {
+    mFirst = nullptr;
+    mLast = nullptr;
+    mCurrent = nullptr;
+}
+
+void Scheduler::addTask(Task& aTask) {
+    if (aTask.mScheduler == this) {
+        return;
+    }
+    if (aTask.mScheduler) {
+        aTask.mScheduler->deleteTask(aTask);
+    }
+    aTask.mScheduler = this;
+    aTask.mNext = nullptr;
+    aTask.mPrev = mLast;
+    if (mLast) {
+        mLast->mNext = &aTask;
+    } else {
+        mFirst = &aTask;
+    }
+    mLast = &aTask;
+}
+
+void Scheduler::deleteTask(Task& aTask) {
+    if (aTask.mScheduler != this) {
+        return;
+    }
+    if (aTask.mPrev) {
+        aTask.mPrev->mNext = aTask.mNext;
+    } else {
+        mFirst = aTask.mNext;
+    }
+    if (aTask.mNext) {
+        aTask.mNext->mPrev = aTask.mPrev;
+    } else {
+        mLast = aTask.mPrev;
+    }
+    aTask.mPrev = nullptr;
+    aTask.mNext = nullptr;
+    aTask.mScheduler = nullptr;
+}
+
+void Scheduler::disableAll() {
+    for (Task* t = mFirst; t; t = t->mNext) {
+        t->disable();
+    }
+}
+
+void Scheduler::enableAll() {
+    for (Task* t = mFirst; t; t = t->mNext) {
+        t->enable();
+    }
+}
+
+bool Scheduler::execute() {
+    bool idleRun = true;
+
+    mCurrent = mFirst;
+    while (mCurrent) {
+        Task* t = mCurrent;
+        do {
+            if (!t->mEnabled) break;
+
+            if (t->mIterations == 0) {
+                t->disable();
+                break;
+            }
+
+            unsigned long m = millis();
+
+#ifdef _TASK_TIMEOUT
+            if (t->mTimeout && (m - t->mStartTime > t->mTimeout)) {
+                t->mTimedOut = true;
+                t->disable();
+                break;
+            }
+#endif
+
+            if (m - t->mPreviousMillis < t->mDelay) break;
+
+            if (t->mIterations > 0) t->mIterations--;
+            t->mRunCounter++;
+            t->mPreviousMillis += t->mDelay;
+            t->mDelay = t->mInterval;
+
+            if (t->Callback()) idleRun = false;
+        } while (0);
+        // Matches TaskScheduler: a task deleted from its own callback ends the pass
+        mCurrent = mCurrent ? mCurrent->mNext : nullptr;
+    }
+    return idleRun;
+}
+
+long Scheduler::timeUntilNextIteration(Task& aTask) {
+    if (!aTask.mEnabled) {
+        return -1;
+    }
+    long d = (long)aTask.mDelay - (long)(millis() - aTask.mPreviousMillis);
+    return d < 0 ? 0 : d;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// =============================================================================
+// test.h - Host regression tests for the SM framework
+// =============================================================================
+// Tests register themselves with SM_TEST(name) like the benchmarks do and
+// fail with SM_CHECK(). sm_test runs them all (or those whose name contains
+// its argument) and exits non-zero if any check failed; ctest runs it.
+// =============================================================================
+
+#include <stdio.h>
+
+typedef void (*smTestFn)();
+
+class smTestRegister {
+public:
+    smTestRegister(const char* name, smTestFn fn);
+};
+
+#define SM_TEST(name) \
+    static void name(); \
+    static smTestRegister name##_register(#name, name); \
+    static void name()
+
+void testFail(const char* file, int line, const char* expr);
+
+#define SM_CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            testFail(__FILE__, __LINE__, #expr); \
+        } \
+    } while (0)
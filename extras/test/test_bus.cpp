@@ -0,0 +1,71 @@
+// =============================================================================
+// test_bus.cpp - smBus wake-up regressions
+// =============================================================================
+
+#include "test.h"
+
+#include <StateMachine.h>
+
+#define EV_PING     1
+#define EV_PONG     2
+
+static unsigned int sPings, sPongs;
+static smBus* sBus;
+
+static void onPing(const smEvent&, void*) {
+    sPings++;
+    sBus->publish(EV_PONG);
+}
+
+static void onPong(const smEvent&, void*) {
+    sPongs++;
+}
+
+// An idle bus sleeps instead of running every millisecond; its group wakes
+// it on the tick after a commit, and does not report idle while events
+// are queued
+SM_TEST(busSleepsUntilCommit) {
+    hostClockSet(1000);
+    sPings = sPongs = 0;
+    Scheduler scheduler;
+    smMachineGroup group, other;
+    smBus bus;
+    sBus = &bus;
+    group.add(bus);
+    bus.subscribe(EV_PING, onPing);
+    bus.subscribe(EV_PONG, onPong);
+    scheduler.addTask(bus);
+    bus.enable();
+    scheduler.execute();
+
+    unsigned long runs = bus.getRunCounter();
+    for (int i = 0; i < 100; i++) {
+        delay(10);
+        SM_CHECK(group.execute() == SM_SLEEP_FOREVER);
+        scheduler.execute();
+    }
+    SM_CHECK(bus.getRunCounter() == runs);
+    SM_CHECK(scheduler.timeUntilNextIteration(bus) > 1000);
+
+    // As from an ISR: nothing but the queue is touched
+    SM_CHECK(bus.publish(EV_PING));
+    scheduler.execute();
+    SM_CHECK(sPings == 0);
+    SM_CHECK(group.execute() == 0);
+    scheduler.execute();
+    SM_CHECK(sPings == 1);
+    SM_CHECK(sPongs == 1);          // published by a subscriber, same run
+    SM_CHECK(group.execute() == SM_SLEEP_FOREVER);
+    SM_CHECK(scheduler.timeUntilNextIteration(bus) > 1000);
+
+    // A bus moved to another group is no longer woken by this one
+    other.add(bus);
+    SM_CHECK(bus.publish(EV_PONG));
+    SM_CHECK(group.execute() == SM_SLEEP_FOREVER);
+    SM_CHECK(other.execute() == 0);
+    scheduler.execute();
+    SM_CHECK(sPongs == 2);
+
+    scheduler.deleteTask(bus);
+    hostClockRun();
+}
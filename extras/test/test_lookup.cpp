@@ -0,0 +1,236 @@
+// =============================================================================
+// test_lookup.cpp - Transition lookup against a reference model
+// =============================================================================
+// ctest runs these in the default (indexed), SM_LINEAR_LOOKUP and
+// SM_TRANSITION_GUARDS builds, so every lookup is held to the same model.
+// =============================================================================
+
+#include "test.h"
+
+#include <StateMachine.h>
+
+#define LOOKUP_STATES   6
+
+class LookupAction : public smAction {
+public:
+    LookupAction() : smAction(nullptr) {}
+    bool onRun() override { return false; }
+};
+
+#ifdef SM_TRANSITION_GUARDS
+static bool lookupPass(smState*, smExitCode_t) { return true; }
+static bool lookupFail(smState*, smExitCode_t) { return false; }
+static bool lookupOddCode(smState*, smExitCode_t exitCode) { return exitCode & 1; }
+#endif
+
+// The rules as documented on smTransition: the first level with a match
+// wins - exact, {state, EXIT_ANY}, {SM_ANY_STATE, code}, then
+// {SM_ANY_STATE, EXIT_ANY} - and within a level the first row in table
+// order whose guard passes
+static smState* lookupModel(const smTransition* rows, smIndex_t numRows,
+                            smState* fromState, smExitCode_t exitCode) {
+    for (uint8_t level = 0; level < 4; level++) {
+        bool anyState = level >= 2;
+        bool anyCode = level == 1 || level == 3;
+        for (smIndex_t i = 0; i < numRows; i++) {
+            const smTransition& t = rows[i];
+            bool stateMatches = anyState ? t.fromState == SM_ANY_STATE : t.fromState == fromState;
+            bool codeMatches = anyCode ? t.exitCondition == EXIT_ANY
+                                       : t.exitCondition == exitCode && exitCode != EXIT_ANY;
+#ifdef SM_TRANSITION_GUARDS
+            if (t.guard && stateMatches && codeMatches && !t.guard(fromState, exitCode)) {
+                continue;
+            }
+#endif
+            if (stateMatches && codeMatches) {
+                return t.toState;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Small deterministic generator, so a failure reproduces
+static uint32_t lookupRandom(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Random tables over a few dense codes and two sparse ones (the any-state
+// lookup has a table and a scan path for those), with random guards in
+// guarded builds, every {state, code} queried against the model
+SM_TEST(lookupMatchesModel) {
+    static const smExitCode_t codes[] = {
+        EXIT_COMPLETE, EXIT_TIMEOUT, EXIT_ERROR, EXIT_USER, EXIT_USER + 1, EXIT_USER + 2, 200, 250
+    };
+    const unsigned int numCodes = sizeof(codes) / sizeof(codes[0]);
+    LookupAction actions[LOOKUP_STATES];
+    smState* states[LOOKUP_STATES];
+    for (unsigned int s = 0; s < LOOKUP_STATES; s++) {
+        states[s] = new smState(&actions[s], "S", 1);
+    }
+
+    uint32_t seed = 1;
+    unsigned long mismatches = 0;
+    for (unsigned int table = 0; table < 500; table++) {
+        smTransition rows[24];
+        smIndex_t numRows = (smIndex_t)(1 + lookupRandom(seed) % 24);
+        for (smIndex_t i = 0; i < numRows; i++) {
+            smState* from = lookupRandom(seed) % 5 ? states[lookupRandom(seed) % LOOKUP_STATES] : SM_ANY_STATE;
+            smExitCode_t code = lookupRandom(seed) % 5 ? codes[lookupRandom(seed) % numCodes] : EXIT_ANY;
+            rows[i] = { from, code, states[lookupRandom(seed) % LOOKUP_STATES] };
+#ifdef SM_TRANSITION_GUARDS
+            static const smGuard guards[] = { nullptr, lookupPass, lookupFail, lookupOddCode };
+            rows[i].guard = guards[lookupRandom(seed) % 4];
+#endif
+        }
+
+        smMachine fsm(states, LOOKUP_STATES, rows, numRows);
+        fsm.begin();
+        for (unsigned int s = 0; s < LOOKUP_STATES; s++) {
+            for (unsigned int c = 0; c < numCodes; c++) {
+                smState* expected = lookupModel(rows, numRows, states[s], codes[c]);
+                if (fsm.findNextState(states[s], codes[c]) != expected) {
+                    mismatches++;
+                }
+            }
+        }
+        // The states outlive this machine's scheduler
+        for (unsigned int s = 0; s < LOOKUP_STATES; s++) {
+            fsm.getScheduler().deleteTask(*states[s]);
+        }
+    }
+    SM_CHECK(mismatches == 0);
+
+    for (unsigned int s = 0; s < LOOKUP_STATES; s++) {
+        delete states[s];
+    }
+}
+
+#define EXIT_X      (EXIT_USER + 0)
+#define EXIT_Y      (EXIT_USER + 1)
+#define EXIT_Z      (EXIT_USER + 2)
+
+// Each level only applies when every level above it has no row
+SM_TEST(lookupPrecedence) {
+    LookupAction actions[5];
+    smState a(&actions[0], "A", 1), b(&actions[1], "B", 1), c(&actions[2], "C", 1),
+            d(&actions[3], "D", 1), e(&actions[4], "E", 1);
+    smState* states[] = { &a, &b, &c, &d, &e };
+    smTransition rows[] = {
+        { SM_ANY_STATE, EXIT_ANY, &e },         // listed first: order does not
+        { SM_ANY_STATE, EXIT_X,   &d },         // decide between levels
+        { SM_ANY_STATE, EXIT_Y,   &d },
+        { &a,           EXIT_ANY, &c },
+        { &a,           EXIT_X,   &b },
+    };
+    smMachine fsm(states, 5, rows, 5);
+    fsm.begin();
+
+    SM_CHECK(fsm.findNextState(&a, EXIT_X) == &b);     // exact
+    SM_CHECK(fsm.findNextState(&a, EXIT_Y) == &c);     // {state, EXIT_ANY} over {SM_ANY_STATE, code}
+    SM_CHECK(fsm.findNextState(&a, EXIT_Z) == &c);     // {state, EXIT_ANY} over the default
+    SM_CHECK(fsm.findNextState(&b, EXIT_X) == &d);     // {SM_ANY_STATE, code}
+    SM_CHECK(fsm.findNextState(&b, EXIT_Y) == &d);
+    SM_CHECK(fsm.findNextState(&b, EXIT_Z) == &e);     // default
+    SM_CHECK(fsm.findNextState(&c, EXIT_ERROR) == &e);
+}
+
+// Within a level the first row in table order wins
+SM_TEST(lookupTableOrder) {
+    LookupAction actions[3];
+    smState a(&actions[0], "A", 1), b(&actions[1], "B", 1), c(&actions[2], "C", 1);
+    smState* states[] = { &a, &b, &c };
+    smTransition rows[] = {
+        { &a,           EXIT_X,   &b },
+        { &a,           EXIT_X,   &c },
+        { &b,           EXIT_ANY, &c },
+        { &b,           EXIT_ANY, &a },
+        { SM_ANY_STATE, EXIT_Y,   &a },
+        { SM_ANY_STATE, EXIT_Y,   &b },
+        { SM_ANY_STATE, EXIT_ANY, &b },
+        { SM_ANY_STATE, EXIT_ANY, &a },
+    };
+    smMachine fsm(states, 3, rows, 8);
+    fsm.begin();
+
+    SM_CHECK(fsm.findNextState(&a, EXIT_X) == &b);
+    SM_CHECK(fsm.findNextState(&b, EXIT_Z) == &c);
+    SM_CHECK(fsm.findNextState(&c, EXIT_Y) == &a);
+    SM_CHECK(fsm.findNextState(&c, EXIT_Z) == &b);
+}
+
+// Without wildcards a code with no row finds nothing
+SM_TEST(lookupNoMatch) {
+    LookupAction actions[2];
+    smState a(&actions[0], "A", 1), b(&actions[1], "B", 1);
+    smState* states[] = { &a, &b };
+    smTransition rows[] = {
+        { &a, EXIT_X, &b },
+        { &b, EXIT_Y, &a },
+    };
+    smMachine fsm(states, 2, rows, 2);
+    fsm.begin();
+
+    SM_CHECK(fsm.findNextState(&a, EXIT_Y) == nullptr);
+    SM_CHECK(fsm.findNextState(&b, EXIT_X) == nullptr);
+    SM_CHECK(fsm.findNextState(&a, EXIT_ANY) == nullptr);
+    SM_CHECK(fsm.findNextState(nullptr, EXIT_X) == nullptr);
+}
+
+#ifdef SM_TRANSITION_GUARDS
+static smState* sGuardExpected;
+
+static bool lookupFromState(smState* state, smExitCode_t exitCode) {
+    return state == sGuardExpected && exitCode == EXIT_Y;
+}
+
+// A rejected guard moves on to the next row with the same {state, code},
+// then to the next level down; a level with no passing row is skipped
+SM_TEST(lookupGuardFallThrough) {
+    LookupAction actions[5];
+    smState a(&actions[0], "A", 1), b(&actions[1], "B", 1), c(&actions[2], "C", 1),
+            d(&actions[3], "D", 1), e(&actions[4], "E", 1);
+    smState* states[] = { &a, &b, &c, &d, &e };
+    smTransition rows[] = {
+        { &a,           EXIT_X,   &b, lookupFail },
+        { &a,           EXIT_X,   &c, lookupPass },
+        { &b,           EXIT_X,   &c, lookupFail },
+        { &b,           EXIT_ANY, &d },
+        { &c,           EXIT_X,   &a, lookupFail },
+        { &c,           EXIT_ANY, &a, lookupFail },
+        { SM_ANY_STATE, EXIT_X,   &d, lookupFail },
+        { SM_ANY_STATE, EXIT_ANY, &e },
+        { &d,           EXIT_Y,   &a, lookupFromState },
+    };
+    smMachine fsm(states, 5, rows, 9);
+    fsm.begin();
+
+    SM_CHECK(fsm.findNextState(&a, EXIT_X) == &c);     // next candidate
+    SM_CHECK(fsm.findNextState(&b, EXIT_X) == &d);     // {state, EXIT_ANY}
+    SM_CHECK(fsm.findNextState(&c, EXIT_X) == &e);     // down to the default
+
+    // Guards see the state being left and the exit code
+    sGuardExpected = &d;
+    SM_CHECK(fsm.findNextState(&d, EXIT_Y) == &a);
+    sGuardExpected = &b;
+    SM_CHECK(fsm.findNextState(&d, EXIT_Y) == &e);
+}
+
+// Every candidate rejected and no wildcard below: no transition
+SM_TEST(lookupGuardNoMatch) {
+    LookupAction actions[2];
+    smState a(&actions[0], "A", 1), b(&actions[1], "B", 1);
+    smState* states[] = { &a, &b };
+    smTransition rows[] = {
+        { &a,           EXIT_X, &b, lookupFail },
+        { &a,           EXIT_X, &a, lookupFail },
+        { SM_ANY_STATE, EXIT_X, &b, lookupFail },
+    };
+    smMachine fsm(states, 2, rows, 3);
+    fsm.begin();
+
+    SM_CHECK(fsm.findNextState(&a, EXIT_X) == nullptr);
+    SM_CHECK(fsm.findNextState(&b, EXIT_X) == nullptr);
+}
+#endif
@@ -0,0 +1,43 @@
+// =============================================================================
+// test_main.cpp - Runs the registered tests
+// =============================================================================
+// Usage: sm_test [filter]
+// =============================================================================
+
+#include "test.h"
+
+#include <string.h>
+
+struct smTestEntry {
+    const char* name;
+    smTestFn fn;
+};
+
+static smTestEntry sTests[64];
+static size_t sCount = 0;
+static unsigned long sFailed = 0;
+
+smTestRegister::smTestRegister(const char* name, smTestFn fn) {
+    if (sCount < sizeof(sTests) / sizeof(sTests[0])) {
+        sTests[sCount].name = name;
+        sTests[sCount].fn = fn;
+        sCount++;
+    }
+}
+
+void testFail(const char* file, int line, const char* expr) {
+    printf("%s:%d: check failed: %s\n", file, line, expr);
+    sFailed++;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    for (size_t i = 0; i < sCount; i++) {
+        if (!filter || strstr(sTests[i].name, filter)) {
+            unsigned long before = sFailed;
+            sTests[i].fn();
+            printf("%s %s\n", sFailed == before ? "ok  " : "FAIL", sTests[i].name);
+        }
+    }
+    return sFailed ? 1 : 0;
+}
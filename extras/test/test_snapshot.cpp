@@ -0,0 +1,88 @@
+// =============================================================================
+// test_snapshot.cpp - Snapshot and restore regressions
+// =============================================================================
+
+#include "test.h"
+
+#include <StateMachine.h>
+
+#define EXIT_GO     1
+
+class IdleAction : public smAction {
+public:
+    IdleAction() : smAction(nullptr) {}
+    bool onRun() override { return false; }
+};
+
+// A state restored without a wheel gets the time its scheduler timeout had
+// left, not the whole timeout again; the next entry has it in full
+SM_TEST(snapshotResumeTimeout) {
+    hostClockSet(5000);
+    IdleAction waitAction, doneAction;
+    smState wait(&waitAction, "WAIT", 1);
+    smState done(&doneAction, "DONE", 1);
+    smState* states[] = { &wait, &done };
+    smTransition rows[] = {
+        { &wait, EXIT_TIMEOUT, &done },
+        { &done, EXIT_GO, &wait },
+    };
+    wait.setTimeout(100);
+    smMachine fsm(states, 2, rows, 2);
+    fsm.begin();
+    fsm.start(&wait);
+    delay(70);
+    fsm.execute();
+    uint8_t blob[SM_SNAPSHOT_SIZE(0)];
+    size_t size = fsm.saveSnapshot(blob, sizeof(blob));
+    SM_CHECK(size == sizeof(blob));
+    fsm.stop();
+
+    delay(1000);
+    SM_CHECK(fsm.restoreSnapshot(blob, size));
+    SM_CHECK(fsm.getCurrentState() == &wait);
+    for (int i = 0; i < 40 && fsm.getCurrentState() == &wait; i++) {
+        delay(1);
+        fsm.execute();
+    }
+    SM_CHECK(fsm.getCurrentState() == &done);
+
+    // Back in WAIT: the full 100 ms again
+    fsm.requestTransition(EXIT_GO);
+    fsm.execute();
+    SM_CHECK(fsm.getCurrentState() == &wait);
+    SM_CHECK(wait.getTimeout() == 100);
+    fsm.stop();
+    hostClockRun();
+}
+
+// Static tables are not in mTransitions[]; their rows still go into the
+// signature, so a snapshot from firmware with another table is rejected
+static IdleAction sIdleA, sIdleB, sIdleC;
+static smState sStateA(&sIdleA, "A", 1), sStateB(&sIdleB, "B", 1), sStateC(&sIdleC, "C", 1);
+static smState* sStates[] = { &sStateA, &sStateB, &sStateC };
+
+SM_TEST(snapshotStaticTable) {
+    smStaticMachine<
+        smRow<&sStateA, EXIT_GO, &sStateB>,
+        smRow<&sStateB, EXIT_GO, &sStateA>
+    > saved(sStates, 3);
+    smStaticMachine<
+        smRow<&sStateA, EXIT_GO, &sStateB>,
+        smRow<&sStateB, EXIT_GO, &sStateC>
+    > changed(sStates, 3);
+
+    saved.begin();
+    saved.start(&sStateB);
+    uint8_t blob[SM_SNAPSHOT_SIZE(0)];
+    size_t size = saved.saveSnapshot(blob, sizeof(blob));
+    SM_CHECK(size == sizeof(blob));
+    saved.stop();
+
+    changed.begin();
+    SM_CHECK(!changed.restoreSnapshot(blob, size));
+
+    saved.begin();
+    SM_CHECK(saved.restoreSnapshot(blob, size));
+    SM_CHECK(saved.getCurrentState() == &sStateB);
+    saved.stop();
+}
@@ -0,0 +1,43 @@
+// =============================================================================
+// test_wheel.cpp - smTimerWheel regressions
+// =============================================================================
+
+#include "test.h"
+
+#include <StateMachine.h>
+
+struct RearmContext {
+    smTimerWheel* wheel;
+    unsigned long fired;
+};
+
+static void rearm(smTimer& timer, void* context) {
+    RearmContext* c = static_cast<RearmContext*>(context);
+    c->fired++;
+    c->wheel->arm(timer, 2);
+}
+
+// A handler re-arming its own timer when advance() runs late: the new
+// expiry must not land in the slot advance() is emptying (which looped
+// forever)
+SM_TEST(wheelRearmLate) {
+    for (unsigned long late = 0; late < 200; late++) {
+        hostClockSet(1000);
+        smTimerWheel wheel;
+        RearmContext c = { &wheel, 0 };
+        smTimer timer(rearm, &c);
+        wheel.arm(timer, 2);
+        delay(2 + late);
+        SM_CHECK(wheel.advance() == 1);
+        SM_CHECK(c.fired == 1);
+        SM_CHECK(timer.isArmed() && timer.getRemaining() == 2);
+
+        // and it fires once more, on time
+        delay(1);
+        SM_CHECK(wheel.advance() == 0);
+        delay(1);
+        SM_CHECK(wheel.advance() == 1);
+        SM_CHECK(c.fired == 2);
+    }
+    hostClockRun();
+}
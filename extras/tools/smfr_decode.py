@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Decode a StateMachine flight recorder dump (smFlightRecorder::dump()).
+
+Accepts the raw binary dump or the hex text form (dump(Serial, true)),
+e.g. copied from a serial monitor. State names are given in state-array
+order, either on the command line or one per line in a file:
+
+    smfr_decode.py dump.bin IDLE RUNNING ERROR
+    smfr_decode.py dump.txt --states states.txt
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"SMFR"
+HEADER = struct.Struct("<4sBBBBHI")
+DELTA_MASK = 0x3FFF
+FORCED = 0x4000
+INVALID = 0x8000
+
+EXIT_NAMES = {
+    0: "EXIT_NONE",
+    1: "EXIT_COMPLETE",
+    2: "EXIT_TIMEOUT",
+    3: "EXIT_ERROR",
+    4: "EXIT_CANCEL",
+    5: "EXIT_ABORT",
+}
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    start = data.find(MAGIC)
+    if start >= 0:
+        return data[start:]
+    # Hex text: the header line, then one line per record. Serial monitors
+    # may prefix lines and the sketch may print around the dump, so only
+    # the hex run from SMFR on and the hex token ending each later line
+    # are kept, and the result is cut to the length the header gives.
+    magic = MAGIC.hex().upper().encode()
+    lines = data.upper().splitlines()
+    for i, line in enumerate(lines):
+        start = line.find(magic)
+        if start >= 0:
+            break
+    else:
+        sys.exit("%s: no flight recorder dump found" % path)
+    text = re.match(rb"[0-9A-F]*", line[start:]).group()
+    for line in lines[i + 1:]:
+        tokens = line.split()
+        if not tokens or not re.fullmatch(rb"[0-9A-F]+", tokens[-1]):
+            break
+        text += tokens[-1]
+    if len(text) >= 2 * HEADER.size:
+        header = HEADER.unpack(bytes.fromhex(text[:2 * HEADER.size].decode()))
+        text = text[:2 * (HEADER.size + header[2] * header[5])]
+    return bytes.fromhex(text[:len(text) & ~1].decode())
+
+
+def state_name(index, names, no_index):
+    if index == no_index:
+        return "-"
+    if index < len(names):
+        return names[index]
+    return "#%d" % index
+
+
+def exit_name(code):
+    if code in EXIT_NAMES:
+        return EXIT_NAMES[code]
+    if code >= 16:
+        return "EXIT_USER+%d" % (code - 16)
+    return str(code)
+
+
+def decode(data, names):
+    magic, version, size, index_bytes, code_bytes, count, last = HEADER.unpack_from(data)
+    if version != 1:
+        sys.exit("unsupported dump version %d" % version)
+    widths = {1: "B", 2: "H", 4: "I"}
+    if index_bytes not in widths or code_bytes not in widths or size != 2 + 2 * index_bytes + code_bytes:
+        sys.exit("unsupported record layout")
+    record = struct.Struct("<H" + widths[index_bytes] + widths[code_bytes] + widths[index_bytes])
+    no_index = (1 << (8 * index_bytes)) - 1
+    body = data[HEADER.size:HEADER.size + size * count]
+    if len(body) < size * count:
+        sys.exit("dump truncated: %d of %d records" % (len(body) // size, count))
+
+    records = []
+    for i in range(count):
+        word, src, code, dst = record.unpack_from(body, i * size)
+        records.append((word, src, code, dst))
+
+    # Timestamps run backwards from the newest record
+    times = [0] * count
+    t = last
+    for i in range(count - 1, -1, -1):
+        times[i] = t
+        t -= records[i][0] & DELTA_MASK
+
+    print("%10s %7s  %-16s %-16s %-16s %s" % ("ms", "+ms", "from", "exit", "to", "flags"))
+    for (word, src, code, dst), t in zip(records, times):
+        delta = word & DELTA_MASK
+        flags = []
+        if word & FORCED:
+            flags.append("forced")
+        if word & INVALID:
+            flags.append("invalid")
+        print("%10d %7s  %-16s %-16s %-16s %s" % (
+            t,
+            ">=%d" % delta if delta == DELTA_MASK else str(delta),
+            state_name(src, names, no_index),
+            "-" if word & FORCED else exit_name(code),
+            state_name(dst, names, no_index),
+            ",".join(flags)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="raw or hex dump file")
+    parser.add_argument("names", nargs="*", help="state names in state-array order")
+    parser.add_argument("--states", help="file with one state name per line")
+    args = parser.parse_args()
+
+    names = list(args.names)
+    if args.states:
+        with open(args.states) as f:
+            names += [line.strip() for line in f if line.strip()]
+    decode(load(args.dump), names)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Decode a StateMachine binary log stream (smLog with setBinary(true)).
+
+Reads a raw capture of the log output ("-" for stdin) and expands each
+record's format ID with the format strings, given one per line in
+format-table order. State names for %S are given in state-array order,
+on the command line or one per line in a file:
+
+    smlog_decode.py capture.bin --formats formats.txt IDLE RUNNING ERROR
+    smlog_decode.py capture.bin --formats formats.txt --states states.txt
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+DROPPED_ID = 0xFFFF
+MAX_ARGS = 16
+HEADER = struct.Struct("<BHBI")
+
+EXIT_NAMES = {
+    0: "EXIT_NONE",
+    1: "EXIT_COMPLETE",
+    2: "EXIT_TIMEOUT",
+    3: "EXIT_ERROR",
+    4: "EXIT_CANCEL",
+    5: "EXIT_ABORT",
+}
+
+CONVERSION = re.compile(r"%(.)")
+
+
+def read_lines(path):
+    with open(path) as f:
+        return [line.rstrip("\r\n") for line in f]
+
+
+def exit_name(code):
+    if code in EXIT_NAMES:
+        return EXIT_NAMES[code]
+    if code >= 16:
+        return "EXIT_USER+%d" % (code - 16)
+    return str(code)
+
+
+def expand(fmt, args, states):
+    values = iter(args)
+
+    def convert(match):
+        c = match.group(1)
+        if c == "%":
+            return "%"
+        if c not in "duxcSE":
+            return match.group(0)
+        v = next(values, None)
+        if v is None:
+            return "?"
+        if c == "d":
+            return str(v)
+        if c == "u":
+            return str(v & 0xFFFFFFFF)
+        if c == "x":
+            return "%X" % (v & 0xFFFFFFFF)
+        if c == "c":
+            return chr(v & 0xFF)
+        if c == "S":
+            return states[v] if 0 <= v < len(states) else "#%d" % v
+        return exit_name(v)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def records(data):
+    """Yield (time, id, args), skipping bytes until the next sync byte."""
+    pos = 0
+    while True:
+        pos = data.find(bytes([SYNC]), pos)
+        if pos < 0 or pos + HEADER.size > len(data):
+            return
+        _, rid, argc, time = HEADER.unpack_from(data, pos)
+        end = pos + HEADER.size + 4 * argc
+        if argc > MAX_ARGS or end > len(data):
+            pos += 1
+            continue
+        args = struct.unpack_from("<%di" % argc, data, pos + HEADER.size)
+        yield time, rid, args
+        pos = end
+
+
+def decode(data, formats, states):
+    last = None
+    for time, rid, args in records(data):
+        delta = ""
+        if last is not None:
+            # Drop reports are stamped when noticed, after the records
+            # queued before them; keep deltas signed across the wrap
+            d = (time - last) & 0xFFFFFFFF
+            delta = "%+d" % (d - (1 << 32) if d >= 1 << 31 else d)
+        last = time
+        if rid == DROPPED_ID:
+            text = "[%d dropped]" % args[0] if args else "[dropped]"
+        elif rid < len(formats):
+            text = expand(formats[rid], args, states)
+        else:
+            text = "#%d %s" % (rid, " ".join(str(a) for a in args))
+        print("%14.3f %10s  %s" % (time / 1000.0, delta, text))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", help="raw log capture, - for stdin")
+    parser.add_argument("names", nargs="*", help="state names in state-array order")
+    parser.add_argument("--formats", required=True, help="file with one format string per line")
+    parser.add_argument("--states", help="file with one state name per line")
+    args = parser.parse_intermixed_args()
+
+    states = list(args.names)
+    if args.states:
+        states += [line.strip() for line in read_lines(args.states) if line.strip()]
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    decode(data, read_lines(args.formats), states)
+
+
+if __name__ == "__main__":
+    main()
@@ -6,11 +6,27 @@
 // Include this single file to get all SM framework components:
 //   - smDevice: Base class for hardware abstraction
 //   - smAction: Base class for state behavior
+//   - smCoAction: Action written as a C++20 coroutine (SM_COROUTINES)
 //   - smState: State wrapper around actions
 //   - smMachine: State machine orchestrator
+//   - smMachineGroup: Runs many machines from one loop
+//   - smSubmachine: Composite state running a child machine
+//   - smStaticMachine: smMachine with a compile-time transition table
+//   - smBatch: Many instances of one machine, stored as arrays
+//   - smLog: Deferred logging drained by a scheduler task
+//   - smBus: Publish/subscribe events between machines and tasks
+//   - smTimerWheel: Timer wheel for state timeouts and action delays
 // =============================================================================
 
 #include "smDevice.h"
 #include "smAction.h"
+#include "smCoAction.h"
 #include "smState.h"
+#include "smMachineGroup.h"
 #include "smMachine.h"
+#include "smSubmachine.h"
+#include "smStaticMachine.h"
+#include "smBatch.h"
+#include "smLog.h"
+#include "smBus.h"
+#include "smTimerWheel.h"
@@ -1,9 +1,33 @@
 #include "smAction.h"
 #include "smMachine.h"
 
-void smAction::requestExit(uint8_t exitCode) {
+void smAction::requestExit(smExitCode_t exitCode) {
     mExitCode = exitCode;
     if (mMachine) {
         mMachine->requestTransition(exitCode);
     }
 }
+
+bool smAction::postExit(smExitCode_t exitCode) {
+#if SM_EVENT_QUEUE_SIZE > 0
+    if (mMachine) {
+        return mMachine->postTransition(exitCode);
+    }
+#endif
+    return false;
+}
+
+void smAction::signal() {
+    if (mMachine) {
+        mMachine->signal();
+    }
+}
+
+bool smAction::postSignal() {
+#if SM_EVENT_QUEUE_SIZE > 0
+    if (mMachine) {
+        return mMachine->postSignal();
+    }
+#endif
+    return false;
+}
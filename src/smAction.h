@@ -5,6 +5,24 @@
 // Forward declaration
 class smMachine;
 
+// Exit code width in bits (8, 16 or 32)
+//   8-bit codes keep transition tables small on AVR; wider codes suit
+//   generated protocol machines. Define it in build flags, not in a sketch,
+//   so the library is compiled with the same value.
+#ifndef SM_EXIT_WIDTH
+#define SM_EXIT_WIDTH           8
+#endif
+
+#if SM_EXIT_WIDTH == 8
+typedef uint8_t smExitCode_t;
+#elif SM_EXIT_WIDTH == 16
+typedef uint16_t smExitCode_t;
+#elif SM_EXIT_WIDTH == 32
+typedef uint32_t smExitCode_t;
+#else
+#error "SM_EXIT_WIDTH must be 8, 16 or 32"
+#endif
+
 // Exit condition codes
 #define EXIT_NONE       0
 #define EXIT_COMPLETE   1   // Normal completion (iterations done)
@@ -14,6 +32,9 @@ class smMachine;
 #define EXIT_ABORT      5   // Aborted (emergency stop)
 // User-defined exit conditions start at 16
 #define EXIT_USER       16
+// Wildcard for smTransition::exitCondition: matches any exit code
+// (reserved; the largest smExitCode_t value)
+#define EXIT_ANY        ((smExitCode_t)~(smExitCode_t)0)
 
 class smAction {
 public:
@@ -21,29 +42,57 @@ public:
         : mName(name), mDevice(aDevice), mMachine(nullptr), mExitCode(EXIT_NONE) {}
     virtual ~smAction() {}
 
-    // Lifecycle
-    virtual bool begin() { return mDevice ? mDevice->begin() : true; }
-    virtual void end() { if (mDevice) mDevice->end(); }
+    // Lifecycle (shared devices are begun once, see smDevice::acquire)
+    virtual bool begin() { return mDevice ? mDevice->acquire() : true; }
+    virtual void end() { if (mDevice) mDevice->release(); }
+
+    // Called on state entry before onEnter() to begin lazy devices
+    // (see smDevice::use); actions owning more than one device override it
+    virtual void useDevices() { if (mDevice) mDevice->use(); }
+
+    // Advance non-blocking device start-up (see smDevice::poll); returns
+    // true while a device is still starting. Actions owning more than one
+    // device override it to poll each (without short-circuiting).
+    virtual bool pollStartup() { return mDevice && mDevice->pollStartup(); }
+    smDevice* getDevice() { return mDevice; }
 
     // Called when action becomes active (state entered)
     virtual void onEnter() {}
 
-    // Called repeatedly while action is active
-    // Return false to signal exit with current exit code
+    // Called repeatedly while action is active; call requestExit() to leave.
+    // Return true if it did work, false if it only polled (lets the
+    // scheduler idle and backs off an adaptive state, see smState)
     virtual bool onRun() = 0;
 
     // Called when action becomes inactive (state exited)
     virtual void onExit() {}
 
     // Called when action signals an exit but transition is invalid
-    virtual void onInvalidTransition(uint8_t exitCode) {}
+    virtual void onInvalidTransition(smExitCode_t exitCode) {}
+
+    // Snapshot hooks (see smMachine::saveSnapshot), current state only:
+    // onSave() writes up to `size` bytes the action needs to carry on after
+    // a restore and returns the count; onRestore() gets them back and runs
+    // instead of onEnter() (return false to reject the snapshot)
+    virtual size_t onSave(uint8_t* buffer, size_t size) { return 0; }
+    virtual bool onRestore(const uint8_t* data, size_t size) { return true; }
 
     // Signal exit with condition code
-    void requestExit(uint8_t exitCode);
+    void requestExit(smExitCode_t exitCode);
+
+    // Signal exit from an ISR or another task (see smMachine::postTransition)
+    // Returns false if the machine's event queue is full or disabled
+    bool postExit(smExitCode_t exitCode);
+
+    // Wake the machine's current state, e.g. from a device callback
+    // (see smState::setEventDriven); postSignal() is the ISR-safe form
+    void signal();
+    bool postSignal();
 
     // Exit code accessors
-    uint8_t getExitCode() { return mExitCode; }
+    smExitCode_t getExitCode() { return mExitCode; }
     void resetExitCode() { mExitCode = EXIT_NONE; }
+    void setExitCode(smExitCode_t exitCode) { mExitCode = exitCode; }
 
     // Machine accessors
     void setMachine(smMachine* machine) { mMachine = machine; }
@@ -57,5 +106,5 @@ protected:
     const char* mName;
     smDevice* mDevice;
     smMachine* mMachine;
-    uint8_t mExitCode;
+    smExitCode_t mExitCode;
 };
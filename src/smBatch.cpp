@@ -0,0 +1,153 @@
+#include "smBatch.h"
+
+smBatch::smBatch(smState* aStates[], smIndex_t aNumStates,
+                 smTransition* aTransitions, smIndex_t aNumTransitions,
+                 size_t aNumInstances)
+    : mStates(aStates)
+    , mTransitions(aTransitions)
+    , mNumStates(aNumStates)
+    , mNumTransitions(aNumTransitions)
+    , mNumInstances(aNumInstances)
+    , mTable(nullptr)
+    , mCodeSpan(0)
+    , mState(nullptr)
+    , mPending(nullptr)
+    , mTransitionCount(0)
+    , mInvalidCount(0)
+    , mDroppedCount(0)
+{
+}
+
+smBatch::~smBatch() {
+    freeArrays();
+}
+
+static smIndex_t smBatchFindState(smState* aStates[], smIndex_t aNumStates, smState* state) {
+    for (smIndex_t i = 0; i < aNumStates; i++) {
+        if (aStates[i] == state) {
+            return i;
+        }
+    }
+    return SM_NO_INDEX;
+}
+
+bool smBatch::begin(smIndex_t initialState) {
+    freeArrays();
+    if (initialState >= mNumStates) {
+        return false;
+    }
+#ifdef SM_TRANSITION_GUARDS
+    // Guards need a state object to ask; instances only have an index
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        if (mTransitions[i].guard) {
+            return false;
+        }
+    }
+#endif
+
+    // Columns EXIT_NONE..codeMax, plus one for every larger exit code
+    // (only wildcard rows can match those)
+    smExitCode_t codeMax = EXIT_NONE;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        smExitCode_t code = mTransitions[i].exitCondition;
+        if (code != EXIT_ANY && code > codeMax) {
+            codeMax = code;
+        }
+    }
+    // Checked before adding, so a code near the type's maximum cannot wrap
+    size_t perState = SM_BATCH_MAX_BYTES / sizeof(smIndex_t) / mNumStates;
+    if (perState < 2 || codeMax > perState - 2) {
+        return false;
+    }
+    mCodeSpan = (size_t)codeMax + 2;
+
+    size_t cells = (size_t)mNumStates * mCodeSpan;
+    mTable = new smIndex_t[cells];
+    mState = new smIndex_t[mNumInstances];
+    mPending = new smExitCode_t[mNumInstances];
+    if (!mTable || !mState || !mPending) {
+        freeArrays();
+        return false;
+    }
+
+    for (size_t c = 0; c < cells; c++) {
+        mTable[c] = SM_NO_INDEX;
+    }
+    for (smIndex_t s = 0; s < mNumStates; s++) {
+        mTable[(size_t)s * mCodeSpan + EXIT_NONE] = s;
+    }
+    // One pass per precedence level (exact, {state, EXIT_ANY},
+    // {SM_ANY_STATE, code}, {SM_ANY_STATE, EXIT_ANY}); each only fills
+    // cells still empty, and within a level the first row wins
+    for (uint8_t level = 0; level < 4; level++) {
+        bool anyState = level >= 2;
+        bool anyCode = level == 1 || level == 3;
+        for (smIndex_t i = 0; i < mNumTransitions; i++) {
+            const smTransition& t = mTransitions[i];
+            if ((t.fromState == SM_ANY_STATE) != anyState || (t.exitCondition == EXIT_ANY) != anyCode ||
+                t.exitCondition == EXIT_NONE) {
+                continue;
+            }
+            smIndex_t to = smBatchFindState(mStates, mNumStates, t.toState);
+            smIndex_t from = anyState ? 0 : smBatchFindState(mStates, mNumStates, t.fromState);
+            smIndex_t fromEnd = anyState ? mNumStates : from + 1;
+            if (to == SM_NO_INDEX || from == SM_NO_INDEX) {
+                continue;
+            }
+            size_t codeFirst = anyCode ? 1 : (size_t)t.exitCondition;
+            size_t codeEnd = anyCode ? mCodeSpan : codeFirst + 1;
+            for (smIndex_t s = from; s < fromEnd; s++) {
+                for (size_t c = codeFirst; c < codeEnd; c++) {
+                    smIndex_t* cell = &mTable[(size_t)s * mCodeSpan + c];
+                    if (*cell == SM_NO_INDEX) {
+                        *cell = to;
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < mNumInstances; i++) {
+        mState[i] = initialState;
+        mPending[i] = EXIT_NONE;
+    }
+    return true;
+}
+
+size_t smBatch::step() {
+    const smIndex_t* __restrict table = mTable;
+    smIndex_t* __restrict state = mState;
+    smExitCode_t* __restrict pending = mPending;
+    const size_t span = mCodeSpan;
+    size_t applied = 0;
+    size_t invalid = 0;
+
+    // No branches on the data: codes past the table read its last column,
+    // and selects replace the "no row" test, so the compiler can unroll
+    // and vectorize the loop
+    for (size_t i = 0; i < mNumInstances; i++) {
+        smIndex_t s = state[i];
+        smExitCode_t code = pending[i];
+        smIndex_t next = table[(size_t)s * span + (code < span - 1 ? code : span - 1)];
+        bool valid = next != SM_NO_INDEX;
+        bool isExit = code != EXIT_NONE;
+        state[i] = valid ? next : s;
+        pending[i] = EXIT_NONE;
+        applied += valid & isExit;
+        invalid += !valid;
+    }
+
+    mTransitionCount += applied;
+    mInvalidCount += invalid;
+    return applied;
+}
+
+void smBatch::freeArrays() {
+    delete[] mTable;
+    delete[] mState;
+    delete[] mPending;
+    mTable = nullptr;
+    mState = nullptr;
+    mPending = nullptr;
+    mCodeSpan = 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "smMachine.h"
+
+// Largest table begin() builds (wide or large exit codes make it grow
+// with the largest code in the rows)
+#ifndef SM_BATCH_MAX_BYTES
+#if defined(__AVR__)
+#define SM_BATCH_MAX_BYTES      512
+#else
+#define SM_BATCH_MAX_BYTES      65536
+#endif
+#endif
+
+// =============================================================================
+// smBatch - Many instances of one machine, stored as arrays
+// =============================================================================
+// For thousands of identical machines (sessions, channels) where a full
+// smMachine with its own smState tasks per instance is too heavy. All
+// instances share one immutable transition table; per instance the batch
+// keeps only a current-state index and a pending exit code:
+//
+//   smBatch sessions(states, NUM_STATES, transitions, NUM_TRANSITIONS, 5000);
+//   sessions.begin(0);                      // every instance in states[0]
+//   sessions.post(id, EXIT_RX_DONE);        // from anywhere in the loop
+//   sessions.step();                        // apply all pending exits
+//   if (sessions.getState(id) == ...) ...
+//
+//   - States are identified by their index in the states array; the smState
+//     objects only name the states - their actions and tasks do not run
+//   - step() applies every pending exit in one branch-free pass over the
+//     arrays (first matching row wins, as in smMachine). An exit code with
+//     no row leaves the instance where it is and counts as invalid.
+//   - begin() builds a dense {state, exitCode} table of
+//     numStates * (maxExitCode + 2) cells with wildcard rows resolved into
+//     it (see smTransition); rows with EXIT_NONE are ignored. Tables over
+//     SM_BATCH_MAX_BYTES are refused.
+//   - post() and step() are for the loop only, after begin()
+// =============================================================================
+
+class smBatch {
+public:
+    smBatch(smState* aStates[], smIndex_t aNumStates,
+            smTransition* aTransitions, smIndex_t aNumTransitions,
+            size_t aNumInstances);
+    ~smBatch();
+
+    // Build the table and put every instance in `initialState`; returns
+    // false if out of memory, over SM_BATCH_MAX_BYTES or a row has a guard
+    bool begin(smIndex_t initialState);
+
+    // Record an exit for an instance; the first exit posted before a step
+    // wins and later ones are dropped (returns false)
+    bool post(size_t instance, smExitCode_t exitCode) {
+        if (mPending[instance] != EXIT_NONE) {
+            mDroppedCount++;
+            return false;
+        }
+        mPending[instance] = exitCode;
+        return true;
+    }
+
+    // Apply every pending exit; returns the number of transitions applied
+    size_t step();
+
+    // Table lookup for one {state, exitCode}; returns SM_NO_INDEX if the
+    // table has no such row
+    smIndex_t findNextState(smIndex_t state, smExitCode_t exitCode) {
+        if (state >= mNumStates) {
+            return SM_NO_INDEX;
+        }
+        return mTable[(size_t)state * mCodeSpan + (exitCode < mCodeSpan - 1 ? exitCode : mCodeSpan - 1)];
+    }
+
+    // Per-instance state
+    smIndex_t getState(size_t instance) { return mState[instance]; }
+    void setState(size_t instance, smIndex_t state) { mState[instance] = state; }
+    smExitCode_t getPending(size_t instance) { return mPending[instance]; }
+    smState* getStateObject(size_t instance) { return mStates[mState[instance]]; }
+
+    size_t getNumInstances() { return mNumInstances; }
+
+    // Counters: transitions applied, exits with no matching row, and
+    // exits dropped by post()
+    unsigned long getTransitionCount() { return mTransitionCount; }
+    unsigned long getInvalidCount() { return mInvalidCount; }
+    unsigned long getDroppedCount() { return mDroppedCount; }
+
+    // Bytes allocated by begin(): shared table, and per instance
+    size_t getTableSize() { return (size_t)mNumStates * mCodeSpan * sizeof(smIndex_t); }
+    static size_t getInstanceSize() { return sizeof(smIndex_t) + sizeof(smExitCode_t); }
+
+private:
+    void freeArrays();
+
+    smState** mStates;
+    smTransition* mTransitions;
+    smIndex_t mNumStates;
+    smIndex_t mNumTransitions;
+    size_t mNumInstances;
+
+    // Dense table: mTable[state * mCodeSpan + exitCode] = next state,
+    // the state itself for EXIT_NONE, SM_NO_INDEX if there is no row;
+    // the last column serves every exit code past the table
+    smIndex_t* mTable;
+    size_t mCodeSpan;
+
+    // Structure of arrays, one element per instance
+    smIndex_t* mState;
+    smExitCode_t* mPending;
+
+    unsigned long mTransitionCount;
+    unsigned long mInvalidCount;
+    unsigned long mDroppedCount;
+};
@@ -0,0 +1,208 @@
+#include "smBus.h"
+#include "smMachine.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+smBus::smBus(unsigned long aInterval)
+    : Task(aInterval, TASK_FOREVER)
+    , mUsed(0)
+    , mEvent(nullptr)
+    , mDropped(0)
+    , mDelivered(0)
+    , mGroup(nullptr)
+    , mNextBus(nullptr)
+{
+    memset(mStart, 0, sizeof(mStart));
+    smDefaultGroup.add(*this);
+}
+
+smBus::~smBus() {
+    if (mGroup) {
+        mGroup->remove(*this);
+    }
+}
+
+bool smBus::subscribe(smEventType_t type, smBusHandler handler, void* context) {
+    return handler && insert(type, { SM_BUS_HANDLER, EXIT_NONE, context, handler });
+}
+
+bool smBus::subscribe(smEventType_t type, smAction& action, smExitCode_t exitCode) {
+    return insert(type, { SM_BUS_ACTION, exitCode, &action, nullptr });
+}
+
+bool smBus::subscribe(smEventType_t type, smMachine& machine, smExitCode_t exitCode) {
+    return insert(type, { SM_BUS_MACHINE, exitCode, &machine, nullptr });
+}
+
+uint8_t smBus::unsubscribe(smEventType_t type, smBusHandler handler, void* context) {
+    return remove(type, SM_BUS_HANDLER, context, handler);
+}
+
+uint8_t smBus::unsubscribe(smEventType_t type, smAction& action) {
+    return remove(type, SM_BUS_ACTION, &action, nullptr);
+}
+
+uint8_t smBus::unsubscribe(smEventType_t type, smMachine& machine) {
+    return remove(type, SM_BUS_MACHINE, &machine, nullptr);
+}
+
+// After the type's existing subscribers, so delivery follows subscription order
+bool smBus::insert(smEventType_t type, const smBusSubscriber& subscriber) {
+    uint8_t count = mStart[SM_BUS_TYPES];
+    if (type >= SM_BUS_TYPES || count >= SM_BUS_SUBSCRIBERS) {
+        return false;
+    }
+    uint8_t at = mStart[type + 1];
+    memmove(&mSubscribers[at + 1], &mSubscribers[at], (size_t)(count - at) * sizeof(smBusSubscriber));
+    mSubscribers[at] = subscriber;
+    for (unsigned int t = type + 1; t <= SM_BUS_TYPES; t++) {
+        mStart[t]++;
+    }
+    return true;
+}
+
+uint8_t smBus::remove(smEventType_t type, uint8_t kind, void* target, smBusHandler handler) {
+    if (type >= SM_BUS_TYPES) {
+        return 0;
+    }
+    uint8_t removed = 0;
+    uint8_t i = mStart[type];
+    while (i < mStart[type + 1]) {
+        const smBusSubscriber& s = mSubscribers[i];
+        if (s.kind != kind || s.target != target || s.handler != handler) {
+            i++;
+            continue;
+        }
+        memmove(&mSubscribers[i], &mSubscribers[i + 1],
+                (size_t)(mStart[SM_BUS_TYPES] - i - 1) * sizeof(smBusSubscriber));
+        for (unsigned int t = type + 1; t <= SM_BUS_TYPES; t++) {
+            mStart[t]--;
+        }
+        removed++;
+    }
+    return removed;
+}
+
+smEvent* smBus::create(smEventType_t type) {
+    if (type >= SM_BUS_TYPES) {
+        return nullptr;
+    }
+    const uint32_t all = SM_BUS_POOL_SIZE == 32 ? 0xFFFFFFFFUL : (1UL << SM_BUS_POOL_SIZE) - 1;
+    uint8_t slot = 0;
+#if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint32_t free = ~mUsed & all;
+        if (!free) {
+            mDropped++;
+            return nullptr;
+        }
+        while (!(free & (1UL << slot))) {
+            slot++;
+        }
+        mUsed |= 1UL << slot;
+    }
+#else
+    uint32_t used = __atomic_load_n(&mUsed, __ATOMIC_RELAXED);
+    for (;;) {
+        uint32_t free = ~used & all;
+        if (!free) {
+            __atomic_fetch_add(&mDropped, 1, __ATOMIC_RELAXED);
+            return nullptr;
+        }
+        slot = (uint8_t)__builtin_ctzl(free);
+        if (__atomic_compare_exchange_n(&mUsed, &used, used | (1UL << slot), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+#endif
+    mPool[slot].type = type;
+    return &mPool[slot];
+}
+
+void smBus::commit(smEvent* event) {
+    // One queue cell per pool slot: never full
+    mQueue.push((uint8_t)(event - mPool));
+}
+
+void smBus::release(smEvent* event) {
+    uint32_t bit = 1UL << (event - mPool);
+#if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        mUsed &= ~bit;
+    }
+#else
+    __atomic_fetch_and(&mUsed, ~bit, __ATOMIC_RELEASE);
+#endif
+}
+
+void smBus::dispatch(const smEvent& event) {
+    if (event.type >= SM_BUS_TYPES) {
+        return;
+    }
+    uint8_t first = mStart[event.type];
+    uint8_t last = mStart[event.type + 1];
+
+    // Action subscriptions match the states current when the event
+    // arrives, not ones an earlier subscriber just entered
+    uint8_t armed[(SM_BUS_SUBSCRIBERS + 7) / 8] = { 0 };
+    for (uint8_t i = first; i < last; i++) {
+        const smBusSubscriber& s = mSubscribers[i];
+        if (s.kind != SM_BUS_ACTION) {
+            continue;
+        }
+        smAction* action = static_cast<smAction*>(s.target);
+        smMachine* machine = action->getMachine();
+        smState* current = machine && machine->isRunning() ? machine->getCurrentState() : nullptr;
+        if (current && current->getAction() == action) {
+            armed[i >> 3] |= (uint8_t)(1 << (i & 7));
+        }
+    }
+
+    const smEvent* outer = mEvent;
+    mEvent = &event;
+    for (uint8_t i = first; i < last; i++) {
+        const smBusSubscriber& s = mSubscribers[i];
+        switch (s.kind) {
+            case SM_BUS_HANDLER:
+                s.handler(event, s.target);
+                break;
+            case SM_BUS_ACTION: {
+                smAction* action = static_cast<smAction*>(s.target);
+                smState* current = action->getMachine()->getCurrentState();
+                // Still current: an earlier subscriber may have moved it on
+                if (!(armed[i >> 3] & (1 << (i & 7))) || !current || current->getAction() != action) {
+                    continue;
+                }
+                if (s.exitCode == EXIT_NONE) {
+                    current->signal();
+                } else {
+                    action->requestExit(s.exitCode);
+                }
+                break;
+            }
+            case SM_BUS_MACHINE:
+                static_cast<smMachine*>(s.target)->broadcast(s.exitCode);
+                break;
+        }
+        mDelivered++;
+    }
+    mEvent = outer;
+}
+
+bool smBus::Callback() {
+    uint8_t slot;
+    unsigned int n = 0;
+    // At most one pool's worth, so events published by subscribers wait
+    // for the next run
+    while (n < SM_BUS_POOL_SIZE && mQueue.pop(slot)) {
+        dispatch(mPool[slot]);
+        release(&mPool[slot]);
+        n++;
+    }
+    // Events published by subscribers: run again on the next pass
+    wake();
+    return n > 0;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "smState.h"
+#include "smQueue.h"
+#include "smMachineGroup.h"
+
+// =============================================================================
+// smBus - Publish/subscribe between machines and application tasks
+// =============================================================================
+// Events are fixed-size POD records in a pool owned by the bus. A publisher
+// claims a slot, writes its payload in place and commits it; the bus is
+// itself a Task, and each run hands every queued event to the subscribers
+// of its type by reference, then frees the slot. Publishing is safe from
+// ISRs and other tasks; subscribers run on the scheduler, between states.
+// The Task sleeps while the queue is empty: like a machine, a bus joins
+// smDefaultGroup when constructed, and the group's next tick wakes it
+// after a commit (see smMachineGroup), so an idle bus does not keep the
+// loop from sleeping.
+//
+//   struct TempReading { int16_t centiC; uint8_t sensor; };
+//   enum { EV_TEMP, EV_DOOR_OPEN };
+//
+//   smBus bus;
+//   fsm.getScheduler().addTask(bus);
+//   bus.enable();
+//
+//   bus.subscribe(EV_TEMP, onTemp);                      // void onTemp(const smEvent& e, void* context)
+//   bus.subscribe(EV_DOOR_OPEN, doorAction, EXIT_DOOR);  // requestExit(EXIT_DOOR) while current
+//   bus.subscribe(EV_DOOR_OPEN, alarmFsm, EXIT_DOOR);    // alarmFsm.broadcast(EXIT_DOOR)
+//
+//   bus.publish(EV_TEMP, TempReading{ 2150, 1 });        // copied into the pool once
+//
+//   smEvent* e = bus.create(EV_TEMP);                    // or written in place
+//   if (e) {
+//       e->as<TempReading>() = { 2150, 1 };
+//       bus.commit(e);
+//   }
+//
+// Subscriptions, by kind:
+//   - handler: called with the event and a context pointer
+//   - action + exit code: the action's requestExit(exitCode) if its state
+//     was current when the event arrived (EXIT_NONE: signal() it instead)
+//   - machine + exit code: broadcast(exitCode), so only a current state
+//     (or region) with a row for it is moved
+// Subscribers are kept in one array sorted by type, with a start offset
+// per type, so dispatch walks exactly the event's subscribers. Subscribe
+// and unsubscribe from setup or the scheduler, not from a subscriber.
+// getEvent() returns the event being delivered, e.g. to read its payload
+// in the onExit()/onEnter() an exit-code subscription triggers.
+// =============================================================================
+
+// Event pool: records in flight (power of two, 2 to 32) and payload bytes
+#ifndef SM_BUS_POOL_SIZE
+#define SM_BUS_POOL_SIZE        8
+#endif
+#ifndef SM_BUS_EVENT_SIZE
+#define SM_BUS_EVENT_SIZE       8
+#endif
+
+// Event types (0 .. SM_BUS_TYPES - 1) and subscriptions per bus (up to 255)
+#ifndef SM_BUS_TYPES
+#define SM_BUS_TYPES            32
+#endif
+#ifndef SM_BUS_SUBSCRIBERS
+#define SM_BUS_SUBSCRIBERS      16
+#endif
+
+// Dispatch task default run interval (ms): asleep until woken by its group
+#define SM_BUS_INTERVAL_MS      SM_SLEEP_FOREVER
+
+static_assert(SM_BUS_POOL_SIZE >= 2 && SM_BUS_POOL_SIZE <= 32 && (SM_BUS_POOL_SIZE & (SM_BUS_POOL_SIZE - 1)) == 0,
+              "smBus: SM_BUS_POOL_SIZE must be a power of two from 2 to 32");
+static_assert(SM_BUS_TYPES >= 1 && SM_BUS_TYPES <= 255, "smBus: SM_BUS_TYPES must be 1 to 255");
+static_assert(SM_BUS_SUBSCRIBERS >= 1 && SM_BUS_SUBSCRIBERS <= 255, "smBus: SM_BUS_SUBSCRIBERS must be 1 to 255");
+
+typedef uint8_t smEventType_t;
+
+struct smEvent {
+    smEventType_t type;
+    alignas(4) uint8_t data[SM_BUS_EVENT_SIZE];
+
+    // Payload as a POD type of at most SM_BUS_EVENT_SIZE bytes
+    template <typename T>
+    T& as() {
+        static_assert(sizeof(T) <= SM_BUS_EVENT_SIZE, "smEvent: payload larger than SM_BUS_EVENT_SIZE");
+        return *reinterpret_cast<T*>(data);
+    }
+    template <typename T>
+    const T& as() const {
+        static_assert(sizeof(T) <= SM_BUS_EVENT_SIZE, "smEvent: payload larger than SM_BUS_EVENT_SIZE");
+        return *reinterpret_cast<const T*>(data);
+    }
+};
+
+typedef void (*smBusHandler)(const smEvent& event, void* context);
+
+class smMachine;
+
+class smBus : public Task {
+public:
+    smBus(unsigned long aInterval = SM_BUS_INTERVAL_MS);
+    ~smBus();
+
+    // Subscribe; false if the table is full or the type out of range
+    bool subscribe(smEventType_t type, smBusHandler handler, void* context = nullptr);
+    bool subscribe(smEventType_t type, smAction& action, smExitCode_t exitCode);
+    bool subscribe(smEventType_t type, smMachine& machine, smExitCode_t exitCode);
+
+    // Remove a subscriber's subscriptions to `type`; returns how many
+    uint8_t unsubscribe(smEventType_t type, smBusHandler handler, void* context = nullptr);
+    uint8_t unsubscribe(smEventType_t type, smAction& action);
+    uint8_t unsubscribe(smEventType_t type, smMachine& machine);
+
+    uint8_t getSubscriberCount(smEventType_t type) {
+        return type < SM_BUS_TYPES ? (uint8_t)(mStart[type + 1] - mStart[type]) : 0;
+    }
+
+    // Producer side (ISRs, other tasks): claim a pool slot (nullptr if
+    // the pool is empty or the type out of range), fill it, commit it.
+    // A claimed slot must be committed or discarded.
+    smEvent* create(smEventType_t type);
+    void commit(smEvent* event);
+    void discard(smEvent* event) { release(event); }
+
+    // Claim, copy `payload` in and publish; false if no slot was free
+    template <typename T>
+    bool publish(smEventType_t type, const T& payload) {
+        smEvent* event = create(type);
+        if (!event) {
+            return false;
+        }
+        event->as<T>() = payload;
+        commit(event);
+        return true;
+    }
+    bool publish(smEventType_t type) {
+        smEvent* event = create(type);
+        if (event) {
+            commit(event);
+        }
+        return event != nullptr;
+    }
+
+    // Scheduler side: deliver `event` to its subscribers now, without
+    // queueing it (it need not come from the pool)
+    void dispatch(const smEvent& event);
+
+    // Event being delivered (nullptr outside dispatch)
+    const smEvent* getEvent() { return mEvent; }
+
+    // Events not published because the pool was empty, and delivered
+    unsigned long getDropped() { return mDropped; }
+    unsigned long getDelivered() { return mDelivered; }
+    static unsigned int capacity() { return SM_BUS_POOL_SIZE; }
+
+    // Events committed and not yet delivered (ISR-safe)
+    bool isPending() { return !mQueue.isEmpty(); }
+
+    // Dispatch task: delivers at most one pool's worth of queued events
+    bool Callback() override;
+
+private:
+    friend class smMachineGroup;
+
+    // Run on the next scheduler pass if events are queued (scheduler side)
+    void wake() {
+        if (isPending()) {
+            forceNextIteration();
+        }
+    }
+
+    enum : uint8_t { SM_BUS_HANDLER, SM_BUS_ACTION, SM_BUS_MACHINE };
+
+    struct smBusSubscriber {
+        uint8_t kind;
+        smExitCode_t exitCode;
+        void* target;               // action, machine or handler context
+        smBusHandler handler;
+    };
+
+    bool insert(smEventType_t type, const smBusSubscriber& subscriber);
+    uint8_t remove(smEventType_t type, uint8_t kind, void* target, smBusHandler handler);
+    void release(smEvent* event);
+
+    // Subscribers sorted by type: mStart[type]..mStart[type + 1]
+    smBusSubscriber mSubscribers[SM_BUS_SUBSCRIBERS];
+    uint8_t mStart[SM_BUS_TYPES + 1];
+
+    // Pool: a bit per claimed slot, and published slot numbers in order
+    smEvent mPool[SM_BUS_POOL_SIZE];
+    volatile uint32_t mUsed;
+    smQueue<uint8_t, SM_BUS_POOL_SIZE> mQueue;
+
+    const smEvent* mEvent;
+    volatile unsigned long mDropped;
+    unsigned long mDelivered;
+
+    smMachineGroup* mGroup;
+    smBus* mNextBus;
+};
@@ -0,0 +1,173 @@
+#include "smCoAction.h"
+#include "smMachine.h"
+
+#if SM_COROUTINES
+
+static_assert(SM_COROUTINE_POOL_SLOTS >= 1 && SM_COROUTINE_POOL_SLOTS <= 32,
+              "smCoPool: 1 to 32 slots");
+
+alignas(alignof(max_align_t)) static uint8_t smCoFrames[SM_COROUTINE_POOL_SLOTS][SM_COROUTINE_FRAME_SIZE];
+
+uint32_t smCoPool::sUsed = 0;
+uint8_t smCoPool::sInUse = 0;
+uint8_t smCoPool::sPeak = 0;
+unsigned long smCoPool::sFailures = 0;
+size_t smCoPool::sLargestFrame = 0;
+
+void* smCoPool::allocate(size_t size) {
+    if (size > sLargestFrame) {
+        sLargestFrame = size;
+    }
+    if (size <= SM_COROUTINE_FRAME_SIZE) {
+        for (uint8_t i = 0; i < SM_COROUTINE_POOL_SLOTS; i++) {
+            if (!(sUsed & (1UL << i))) {
+                sUsed |= 1UL << i;
+                if (++sInUse > sPeak) {
+                    sPeak = sInUse;
+                }
+                return smCoFrames[i];
+            }
+        }
+    }
+    sFailures++;
+    return nullptr;
+}
+
+void smCoPool::release(void* frame) {
+    size_t i = (size_t)((uint8_t*)frame - &smCoFrames[0][0]) / SM_COROUTINE_FRAME_SIZE;
+    if (i < SM_COROUTINE_POOL_SLOTS && (sUsed & (1UL << i))) {
+        sUsed &= ~(1UL << i);
+        sInUse--;
+    }
+}
+
+void smCoAction::onEnter() {
+    // run() starts on the first onRun(), which also covers a resumed state
+    // (smState::resume() skips onEnter())
+    mFinished = false;
+}
+
+bool smCoAction::onRun() {
+    if (mOwner) {
+        return false;
+    }
+    if (!mTask) {
+        if (mFinished) {
+            if (mState) {
+                mState->delay(SM_SLEEP_FOREVER);
+            }
+            return false;
+        }
+        mState = getMachine() ? getMachine()->getCurrentState() : nullptr;
+        mTask = run();
+        if (!mTask) {
+            mFinished = true;
+            requestExit(EXIT_ERROR);
+            return false;
+        }
+        mResume = mTask.getHandle();
+        mWait = SM_CO_READY;
+    }
+
+    switch (mWait) {
+    case SM_CO_SLEEP: {
+        // Woken early (signal() or a shared wake-up): sleep the rest
+        long left = (long)(mWakeAt - millis());
+        if (left > 0) {
+            if (mState) {
+                mState->delay((unsigned long)left);
+            }
+            return false;
+        }
+        break;
+    }
+    case SM_CO_UNTIL:
+        if (!mCheck(mCheckArg)) {
+            return false;
+        }
+        break;
+    default:
+        break;
+    }
+    return resume();
+}
+
+bool smCoAction::resume() {
+    std::coroutine_handle<> h = mResume;
+    mResume = nullptr;
+    mWait = SM_CO_READY;
+    if (!h) {
+        return false;
+    }
+    mInResume = true;
+    h.resume();
+    mInResume = false;
+
+    if (mAbandoned) {
+        // The body left the state (requestExit() without co_return)
+        mAbandoned = false;
+        mResume = nullptr;
+        mWait = SM_CO_READY;
+        mTask.reset();
+        return true;
+    }
+    if (mTask.isDone()) {
+        smExitCode_t exitCode = mTask.getResult();
+        mTask.reset();
+        mFinished = true;
+        if (mState) {
+            mState->delay(SM_SLEEP_FOREVER);
+        }
+        if (exitCode != EXIT_NONE) {
+            requestExit(exitCode);
+        }
+    }
+    return true;
+}
+
+void smCoAction::onExit() {
+    if (mInResume) {
+        // Still running inside the frame; resume() destroys it on return
+        mAbandoned = true;
+    } else {
+        mTask.reset();
+        mResume = nullptr;
+        mWait = SM_CO_READY;
+    }
+    mFinished = false;
+}
+
+void smCoAction::suspend(std::coroutine_handle<> h, uint8_t wait, unsigned long ms) {
+    smCoAction* a = root();
+    a->mResume = h;
+    a->mWait = wait;
+    if (wait == SM_CO_SLEEP) {
+        a->mWakeAt = millis() + ms;
+    }
+    if (a->mAbandoned || !a->mState) {
+        return;
+    }
+    if (wait == SM_CO_SLEEP) {
+        // delay(0) would mean "one interval"; a 0 ms sleep runs on the next pass
+        if (ms) {
+            a->mState->delay(ms);
+        } else {
+            a->mState->forceNextIteration();
+        }
+    } else if (wait == SM_CO_SIGNAL) {
+        a->mState->delay(SM_SLEEP_FOREVER);
+    }
+}
+
+void smCoAction::suspendUntil(std::coroutine_handle<> h, bool (*check)(void*), void* arg) {
+    smCoAction* a = root();
+    a->mCheck = check;
+    a->mCheckArg = arg;
+    suspend(h, SM_CO_UNTIL, 0);
+    if (!a->mAbandoned && a->mState && !a->mState->isEventDriven()) {
+        // Poll at the state's interval
+        a->mState->delay(0);
+    }
+}
+
+#endif
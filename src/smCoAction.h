@@ -0,0 +1,283 @@
+#pragma once
+
+#include "smAction.h"
+#include "smState.h"
+
+// =============================================================================
+// smCoAction - Action whose body is a C++20 coroutine
+// =============================================================================
+// Instead of re-checking timers on every onRun() call, the body suspends
+// and the state's task is only run again when the awaited condition can
+// have changed:
+//
+//   class BlinkAction : public smCoAction {
+//       smCoTask run() override {
+//           for (int i = 0; i < 10; i++) {
+//               mLed->toggle();
+//               co_await sleep(500);           // state sleeps 500 ms
+//           }
+//           co_return EXIT_COMPLETE;           // requestExit(EXIT_COMPLETE)
+//       }
+//   };
+//
+//   co_await sleep(ms)          resume after ms milliseconds
+//   co_await signaled()         resume on the next signal() / postSignal()
+//   co_await until(predicate)   resume once predicate() is true, checked
+//                               every state interval (or on signal() for
+//                               an event-driven state)
+//   co_await call(child)        run another smCoAction's run() as a child,
+//                               resume with its co_return value
+//   co_await helper()           any member returning smCoTask
+//
+//   - run() starts on the state's first run after entry; leaving the state
+//     destroys the frame (locals' destructors run). A restored state
+//     (smMachine::restoreSnapshot) starts run() from the top.
+//   - co_return EXIT_NONE ends the body without an exit request
+//   - The body must only co_await the awaitables above; call requestExit()
+//     only as the last thing before co_return
+//   - The action drives its state's delay itself: do not make the state
+//     adaptive (smState::setAdaptiveInterval)
+//
+// Frames come from a static pool of SM_COROUTINE_POOL_SLOTS slots of
+// SM_COROUTINE_FRAME_SIZE bytes, so nothing is allocated from the heap.
+// Every running coroutine (run(), each awaited helper, each call()ed child)
+// holds one slot. A frame that does not fit fails the coroutine: run()
+// exits with EXIT_ERROR, an awaited helper returns EXIT_ERROR.
+//
+// SM_COROUTINES is 1 when the toolchain supports C++20 coroutines (and 0
+// otherwise, where smCoAction is not declared); keep an onRun() version
+// of the action for such toolchains:
+//
+//   #if SM_COROUTINES
+//   class BlinkAction : public smCoAction { ... run() ... };
+//   #else
+//   class BlinkAction : public smAction { ... onRun() ... };
+//   #endif
+// =============================================================================
+
+#ifndef SM_COROUTINES
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define SM_COROUTINES           1
+#endif
+#endif
+#endif
+#ifndef SM_COROUTINES
+#define SM_COROUTINES           0
+#endif
+
+#if SM_COROUTINES
+
+#include <coroutine>
+
+// Frame pool (at most 32 slots)
+#ifndef SM_COROUTINE_POOL_SLOTS
+#define SM_COROUTINE_POOL_SLOTS 4
+#endif
+#ifndef SM_COROUTINE_FRAME_SIZE
+#define SM_COROUTINE_FRAME_SIZE 256
+#endif
+
+class smCoPool {
+public:
+    static void* allocate(size_t size);
+    static void release(void* frame);
+
+    // Slots in use now and at most; frames that did not fit or found no
+    // free slot; largest frame requested (to size SM_COROUTINE_FRAME_SIZE)
+    static uint8_t getInUse() { return sInUse; }
+    static uint8_t getPeak() { return sPeak; }
+    static unsigned long getFailures() { return sFailures; }
+    static size_t getLargestFrame() { return sLargestFrame; }
+
+private:
+    static uint32_t sUsed;
+    static uint8_t sInUse;
+    static uint8_t sPeak;
+    static unsigned long sFailures;
+    static size_t sLargestFrame;
+};
+
+// Coroutine returned by smCoAction::run() and its helpers; co_return an
+// exit code. Owns its frame (destroyed with it).
+class smCoTask {
+public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    // On completion, continue with the awaiting coroutine (if any)
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle h) noexcept {
+            std::coroutine_handle<> next = h.promise().mContinuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    struct promise_type {
+        smExitCode_t mResult = EXIT_NONE;
+        std::coroutine_handle<> mContinuation;
+
+        smCoTask get_return_object() { return smCoTask(Handle::from_promise(*this)); }
+        static smCoTask get_return_object_on_allocation_failure() { return smCoTask(); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(smExitCode_t exitCode) { mResult = exitCode; }
+        void unhandled_exception() { mResult = EXIT_ERROR; }
+
+        static void* operator new(size_t size) noexcept { return smCoPool::allocate(size); }
+        static void operator delete(void* frame) noexcept { smCoPool::release(frame); }
+    };
+
+    smCoTask() : mHandle(nullptr) {}
+    smCoTask(smCoTask&& other) noexcept : mHandle(other.mHandle) { other.mHandle = nullptr; }
+    smCoTask& operator=(smCoTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            mHandle = other.mHandle;
+            other.mHandle = nullptr;
+        }
+        return *this;
+    }
+    smCoTask(const smCoTask&) = delete;
+    smCoTask& operator=(const smCoTask&) = delete;
+    ~smCoTask() { reset(); }
+
+    // False if the frame could not be allocated
+    explicit operator bool() const { return (bool)mHandle; }
+    bool isDone() { return !mHandle || mHandle.done(); }
+    smExitCode_t getResult() { return mHandle ? mHandle.promise().mResult : EXIT_ERROR; }
+    Handle getHandle() { return mHandle; }
+    void reset() {
+        if (mHandle) {
+            mHandle.destroy();
+            mHandle = nullptr;
+        }
+    }
+
+    // Awaiting a task runs it to completion as a sub-coroutine
+    bool await_ready() noexcept { return !mHandle; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept {
+        mHandle.promise().mContinuation = parent;
+        return mHandle;
+    }
+    smExitCode_t await_resume() noexcept { return getResult(); }
+
+private:
+    explicit smCoTask(Handle h) : mHandle(h) {}
+
+    Handle mHandle;
+};
+
+class smCoAction : public smAction {
+public:
+    smCoAction(smDevice* aDevice, const char* name = "ACTION")
+        : smAction(aDevice, name)
+        , mOwner(nullptr)
+        , mState(nullptr)
+        , mWait(SM_CO_READY)
+        , mWakeAt(0)
+        , mCheck(nullptr)
+        , mCheckArg(nullptr)
+        , mFinished(false)
+        , mInResume(false)
+        , mAbandoned(false)
+    {}
+
+    // The action body
+    virtual smCoTask run() = 0;
+
+    void onEnter() final;
+    bool onRun() final;
+    void onExit() final;
+
+    // True while run() is suspended
+    bool isSuspended() { return (bool)mResume; }
+
+protected:
+    struct smCoSleep {
+        smCoAction* mAction;
+        unsigned long mMs;
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { mAction->suspend(h, SM_CO_SLEEP, mMs); }
+        void await_resume() noexcept {}
+    };
+
+    struct smCoSignal {
+        smCoAction* mAction;
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { mAction->suspend(h, SM_CO_SIGNAL, 0); }
+        void await_resume() noexcept {}
+    };
+
+    template <typename F>
+    struct smCoUntil {
+        smCoAction* mAction;
+        F mPredicate;
+        bool await_ready() { return mPredicate(); }
+        void await_suspend(std::coroutine_handle<> h) noexcept {
+            mAction->suspendUntil(h, &smCoUntil::check, this);
+        }
+        void await_resume() noexcept {}
+        static bool check(void* self) { return static_cast<smCoUntil*>(self)->mPredicate(); }
+    };
+
+    // Runs child.run() with this action's state; the child's frame is
+    // destroyed with the awaiting coroutine
+    struct smCoCall {
+        smCoAction* mAction;
+        smCoAction* mChild;
+        smCoTask mTask;
+        ~smCoCall() { mChild->mOwner = nullptr; }
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept {
+            mChild->mOwner = mAction;
+            mTask = mChild->run();
+            if (!mTask) {
+                return parent;
+            }
+            mTask.getHandle().promise().mContinuation = parent;
+            return mTask.getHandle();
+        }
+        smExitCode_t await_resume() noexcept {
+            mChild->mOwner = nullptr;
+            return mTask.getResult();
+        }
+    };
+
+    [[nodiscard]] smCoSleep sleep(unsigned long ms) { return smCoSleep{ this, ms }; }
+    [[nodiscard]] smCoSignal signaled() { return smCoSignal{ this }; }
+    template <typename F>
+    [[nodiscard]] smCoUntil<F> until(F predicate) { return smCoUntil<F>{ this, predicate }; }
+    [[nodiscard]] smCoCall call(smCoAction& child) { return smCoCall{ this, &child, smCoTask() }; }
+
+private:
+    enum : uint8_t { SM_CO_READY, SM_CO_SLEEP, SM_CO_SIGNAL, SM_CO_UNTIL };
+
+    // The action whose state runs this one (itself unless call()ed)
+    smCoAction* root() {
+        smCoAction* a = this;
+        while (a->mOwner) {
+            a = a->mOwner;
+        }
+        return a;
+    }
+    void suspend(std::coroutine_handle<> h, uint8_t wait, unsigned long ms);
+    void suspendUntil(std::coroutine_handle<> h, bool (*check)(void*), void* arg);
+    bool resume();
+
+    smCoAction* mOwner;
+    smState* mState;
+    smCoTask mTask;
+    std::coroutine_handle<> mResume;
+    uint8_t mWait;
+    unsigned long mWakeAt;
+    bool (*mCheck)(void*);
+    void* mCheckArg;
+    bool mFinished;
+    bool mInResume;
+    bool mAbandoned;
+};
+
+#endif
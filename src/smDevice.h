@@ -2,6 +2,11 @@
 
 #include <Arduino.h>
 
+// Default limit on a device's non-blocking start-up (see smDevice::poll)
+#ifndef SM_STARTUP_TIMEOUT_MS
+#define SM_STARTUP_TIMEOUT_MS   5000
+#endif
+
 typedef enum {
     smON,
     smOFF,
@@ -11,7 +16,10 @@ typedef enum {
 
 class smDevice {
 public:
-    smDevice(const char* name = "DEVICE") : mName(name), mState(smOFF) {}
+    smDevice(const char* name = "DEVICE")
+        : mName(name), mState(smOFF), mStartupTimeout(SM_STARTUP_TIMEOUT_MS),
+          mStartTime(0), mStartupTime(0), mStartupFailed(false),
+          mRefCount(0), mBegun(false), mLazy(false) {}
     virtual ~smDevice() {}
 
     virtual bool begin() = 0;   // Initialize hardware
@@ -19,6 +27,67 @@ public:
     virtual void stop() = 0;    // Turn off / deactivate
     virtual void end() = 0;     // Release hardware
 
+    // Shared lifecycle for a device used by several actions: actions call
+    // acquire() from their begin() and release() from their end(). Only the
+    // first acquire() calls begin() (retried while it fails) and only the
+    // last release() calls end().
+    bool acquire() {
+        mRefCount++;
+        if (!mLazy && !mBegun) {
+            mBegun = begin();
+        }
+        return mBegun || mLazy;
+    }
+    void release() {
+        if (mRefCount && --mRefCount == 0 && mBegun) {
+            end();
+            mBegun = false;
+        }
+    }
+
+    // Lazy devices are not begun by acquire() but by use(), which smState
+    // calls (through smAction::useDevices) when a state using the device is
+    // entered; hardware of states never entered stays off. Set before begin.
+    // A lazy device whose begin() reports smSTARTING is polled from the
+    // entered state's runs (at its interval) until ready, failed or timed
+    // out; check getState() before using it from onRun().
+    void use() {
+        if (mLazy && mRefCount && !mBegun) {
+            mBegun = begin();
+        }
+    }
+    void setLazy(bool lazy) { mLazy = lazy; }
+    bool isLazy() { return mLazy; }
+    bool isBegun() { return mBegun; }
+    uint8_t getRefCount() { return mRefCount; }
+
+    // Non-blocking start-up
+    //   A slow device's begin() starts its warm-up, calls setState(smSTARTING)
+    //   and returns true. poll() is then called cooperatively (see
+    //   smMachine::setAsyncStartup) until it calls setState(smOFF) when
+    //   ready; return false if start-up failed.
+    virtual bool poll() { return true; }
+
+    // Drive poll() while starting; returns true until the device is ready,
+    // failed or exceeded its start-up timeout (then smOFF and failed)
+    bool pollStartup() {
+        if (mState != smSTARTING) {
+            return false;
+        }
+        if (!poll() || (mState == smSTARTING && millis() - mStartTime > mStartupTimeout)) {
+            mStartupFailed = true;
+            setState(smOFF);
+        }
+        return mState == smSTARTING;
+    }
+
+    // Start-up limit, and ms the device last spent in smSTARTING
+    // (so far, while still starting)
+    void setStartupTimeout(unsigned long timeout) { mStartupTimeout = timeout; }
+    unsigned long getStartupTimeout() { return mStartupTimeout; }
+    unsigned long getStartupTime() { return mState == smSTARTING ? millis() - mStartTime : mStartupTime; }
+    bool isStartupFailed() { return mStartupFailed; }
+
     // State accessors
     smDeviceState_t getState() { return mState; }
 
@@ -27,8 +96,23 @@ public:
     void setName(const char* name) { mName = name; }
 
 protected:
-    void setState(smDeviceState_t state) { mState = state; }
+    void setState(smDeviceState_t state) {
+        if (state == smSTARTING && mState != smSTARTING) {
+            mStartTime = millis();
+            mStartupFailed = false;
+        } else if (state != smSTARTING && mState == smSTARTING) {
+            mStartupTime = millis() - mStartTime;
+        }
+        mState = state;
+    }
 
     const char* mName;
     smDeviceState_t mState;
+    unsigned long mStartupTimeout;
+    unsigned long mStartTime;
+    unsigned long mStartupTime;
+    bool mStartupFailed;
+    uint8_t mRefCount;
+    bool mBegun;
+    bool mLazy;
 };
@@ -0,0 +1,58 @@
+#include "smFlightRecorder.h"
+
+smFlightRecorder::smFlightRecorder(uint8_t* aBuffer, uint16_t aCapacity)
+    : mBuffer(aBuffer)
+    , mCapacity(aCapacity)
+{
+    clear();
+}
+
+void smFlightRecorder::clear() {
+    mHead = 0;
+    mCount = 0;
+    mTotal = 0;
+    mLastTime = millis();
+}
+
+const uint8_t* smFlightRecorder::getRecord(uint16_t i) {
+    if (i >= mCount) {
+        return nullptr;
+    }
+    uint16_t slot = (mCount < mCapacity) ? i : (uint16_t)((mHead + i) % mCapacity);
+    return &mBuffer[(size_t)slot * SM_RECORD_SIZE];
+}
+
+static size_t smWriteBytes(Print& out, const uint8_t* data, size_t len, bool hex) {
+    static const char digits[] = "0123456789ABCDEF";
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (hex) {
+            n += out.write((uint8_t)digits[data[i] >> 4]);
+            n += out.write((uint8_t)digits[data[i] & 0x0F]);
+        } else {
+            n += out.write(data[i]);
+        }
+    }
+    return n;
+}
+
+size_t smFlightRecorder::dump(Print& out, bool hex) {
+    uint8_t header[14] = {
+        'S', 'M', 'F', 'R', 1, SM_RECORD_SIZE,
+        sizeof(smIndex_t), sizeof(smExitCode_t),
+        (uint8_t)mCount, (uint8_t)(mCount >> 8),
+        (uint8_t)mLastTime, (uint8_t)(mLastTime >> 8),
+        (uint8_t)(mLastTime >> 16), (uint8_t)(mLastTime >> 24)
+    };
+    size_t n = smWriteBytes(out, header, sizeof(header), hex);
+    if (hex) {
+        n += out.println();
+    }
+    for (uint16_t i = 0; i < mCount; i++) {
+        n += smWriteBytes(out, getRecord(i), SM_RECORD_SIZE, hex);
+        if (hex) {
+            n += out.println();
+        }
+    }
+    return n;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "smState.h"
+
+// =============================================================================
+// smFlightRecorder - Fixed-size ring of recent transitions for post-mortem
+// =============================================================================
+// Each transition is stored as a packed record, little-endian fields
+// (5 bytes with the default 8-bit SM_INDEX_WIDTH and SM_EXIT_WIDTH):
+//
+//   uint16    bits 0-13 ms since the previous record (saturates at
+//             16383), bit 14 forced, bit 15 invalid
+//   index     from-state index (SM_NO_INDEX if none)
+//   exit code
+//   index     to-state index (SM_NO_INDEX for an invalid transition)
+//
+// dump() writes a header followed by the records, oldest first:
+//
+//   "SMFR", version (1), record size, index bytes, exit code bytes,
+//   record count (uint16), millis() of the newest record (uint32)
+//
+// extras/tools/smfr_decode.py turns a dump back into state names.
+// =============================================================================
+
+#define SM_RECORD_SIZE          (2 + (2 * SM_INDEX_WIDTH + SM_EXIT_WIDTH) / 8)
+#define SM_RECORD_DELTA_MASK    0x3FFF
+#define SM_RECORD_FORCED        0x4000
+#define SM_RECORD_INVALID       0x8000
+
+class smFlightRecorder {
+public:
+    smFlightRecorder(uint8_t* aBuffer, uint16_t aCapacity);
+
+    void record(smIndex_t from, smExitCode_t exitCode, smIndex_t to, uint16_t flags) {
+        unsigned long now = millis();
+        unsigned long delta = now - mLastTime;
+        uint16_t word = (uint16_t)(delta > SM_RECORD_DELTA_MASK ? SM_RECORD_DELTA_MASK : delta) | flags;
+        uint8_t* r = &mBuffer[(size_t)mHead * SM_RECORD_SIZE];
+        r = put(r, word);
+        r = put(r, from);
+        r = put(r, exitCode);
+        put(r, to);
+        mLastTime = now;
+        mTotal++;
+        if (++mHead == mCapacity) {
+            mHead = 0;
+        }
+        if (mCount < mCapacity) {
+            mCount++;
+        }
+    }
+
+    void clear();
+
+    // Records held (up to the capacity) and total ever recorded
+    uint16_t getCount() { return mCount; }
+    uint16_t getCapacity() { return mCapacity; }
+    unsigned long getTotal() { return mTotal; }
+
+    // Raw record i, 0 = oldest
+    const uint8_t* getRecord(uint16_t i);
+
+    // Write header and records, raw or as hex text (for a serial monitor)
+    size_t dump(Print& out, bool hex = false);
+
+private:
+    template <typename T>
+    static uint8_t* put(uint8_t* p, T value) {
+        for (uint8_t i = 0; i < sizeof(T); i++) {
+            *p++ = (uint8_t)(value >> (8 * i));
+        }
+        return p;
+    }
+
+    uint8_t* mBuffer;
+    uint16_t mCapacity;
+    uint16_t mHead;
+    uint16_t mCount;
+    unsigned long mTotal;
+    unsigned long mLastTime;
+};
@@ -0,0 +1,51 @@
+#include "smHistogram.h"
+
+void smHistogram::clear() {
+    memset(mBuckets, 0, sizeof(mBuckets));
+    mCount = 0;
+    mMax = 0;
+}
+
+unsigned long smHistogram::getPercentile(uint8_t percent) {
+    if (mCount == 0) {
+        return 0;
+    }
+    // Rank of the sample, rounded up, without overflowing mCount * percent
+    unsigned long rank = mCount / 100 * percent + (mCount % 100 * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    unsigned long seen = 0;
+    for (uint8_t i = 0; i < SM_LATENCY_BUCKETS - 1; i++) {
+        seen += mBuckets[i];
+        if (seen >= rank) {
+            unsigned long limit = getBucketLimit(i);
+            return limit < mMax ? limit : mMax;
+        }
+    }
+    return mMax;
+}
+
+size_t smHistogram::dump(Print& out) {
+    size_t n = out.print("n=");
+    n += out.print(mCount);
+    n += out.print(" p50=");
+    n += out.print(getPercentile(50));
+    n += out.print(" p99=");
+    n += out.print(getPercentile(99));
+    n += out.print(" max=");
+    n += out.println(mMax);
+    for (uint8_t i = 0; i < SM_LATENCY_BUCKETS; i++) {
+        if (mBuckets[i]) {
+            n += out.print("<=");
+            if (i < SM_LATENCY_BUCKETS - 1) {
+                n += out.print(getBucketLimit(i));
+            } else {
+                n += out.print("max");
+            }
+            n += out.print(' ');
+            n += out.println(mBuckets[i]);
+        }
+    }
+    return n;
+}
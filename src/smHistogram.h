@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+// =============================================================================
+// smHistogram - Fixed-size log2 histogram of latencies
+// =============================================================================
+// SM_LATENCY_BUCKETS buckets, no allocation: bucket 0 counts 0, bucket
+// i counts [2^(i-1), 2^i - 1], the last bucket counts everything above.
+// The maximum is kept exactly; percentiles are reported as the upper
+// bound of their bucket (at most 2x the true value), capped at the maximum.
+//
+//   smHistogram h;
+//   fsm.getLatency(h);                  // copy, the machine keeps running
+//   h.getPercentile(99);                // p99 in SM_LATENCY_CLOCK ticks
+//   h.dump(Serial);                     // one text line per bucket
+// =============================================================================
+
+// Number of buckets (the last one holds everything from 2^(N-2) ticks on)
+#ifndef SM_LATENCY_BUCKETS
+#define SM_LATENCY_BUCKETS      16
+#endif
+
+class smHistogram {
+public:
+    smHistogram() { clear(); }
+
+    void record(unsigned long value) {
+        uint8_t bucket = 0;
+        for (unsigned long v = value; v && bucket < SM_LATENCY_BUCKETS - 1; v >>= 1) {
+            bucket++;
+        }
+        mBuckets[bucket]++;
+        mCount++;
+        if (value > mMax) {
+            mMax = value;
+        }
+    }
+
+    void clear();
+
+    unsigned long getCount() { return mCount; }
+    unsigned long getMax() { return mMax; }
+    unsigned long getBucket(uint8_t i) { return i < SM_LATENCY_BUCKETS ? mBuckets[i] : 0; }
+
+    // Largest value counted in bucket i (the last bucket is open-ended)
+    static unsigned long getBucketLimit(uint8_t i) { return i ? (1UL << i) - 1 : 0; }
+
+    // Value below or at which `percent` of the samples lie (0 if empty)
+    unsigned long getPercentile(uint8_t percent);
+
+    // "n=.. p50=.. p99=.. max=.." followed by the non-empty buckets
+    size_t dump(Print& out);
+
+private:
+    unsigned long mBuckets[SM_LATENCY_BUCKETS];
+    unsigned long mCount;
+    unsigned long mMax;
+};
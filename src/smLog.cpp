@@ -0,0 +1,216 @@
+#include "smLog.h"
+
+smLog::smLog(Print& aOut, unsigned long aInterval)
+    : Task(aInterval, TASK_FOREVER)
+    , mOut(aOut)
+    , mFormats(nullptr)
+    , mNumFormats(0)
+    , mStates(nullptr)
+    , mNumStates(0)
+    , mBatch(SM_LOG_BATCH)
+    , mBinary(false)
+    , mNonBlocking(true)
+    , mRoomKnown(false)
+    , mDrained(0)
+    , mReported(0)
+    , mLineLength(0)
+{
+}
+
+bool smLog::Callback() {
+    return drain(mBatch);
+}
+
+void smLog::flush() {
+    bool nonBlocking = mNonBlocking;
+    mNonBlocking = false;
+    while (drain(0xFF)) {}
+    mNonBlocking = nonBlocking;
+}
+
+bool smLog::drain(uint8_t limit) {
+    uint8_t n = 0;
+    while (n < limit) {
+        if (!mLineLength) {
+            smLogRecord r;
+            if (!nextRecord(r)) {
+                break;
+            }
+            if (mBinary) {
+                formatBinary(r);
+            } else {
+                formatText(r);
+            }
+        }
+        if (!writeLine()) {
+            break;
+        }
+        n++;
+    }
+    return n > 0;
+}
+
+// A drop report if records were rejected since the last one, else the
+// oldest queued record
+bool smLog::nextRecord(smLogRecord& r) {
+    unsigned long dropped = getDropped();
+    if (dropped != mReported) {
+        r.time = (uint32_t)SM_LOG_CLOCK();
+        r.id = SM_LOG_DROPPED_ID;
+        r.argc = 1;
+        r.args[0] = (int32_t)(dropped - mReported);
+        mReported = dropped;
+        return true;
+    }
+    if (mQueue.pop(r)) {
+        mDrained++;
+        return true;
+    }
+    return false;
+}
+
+bool smLog::writeLine() {
+    if (mNonBlocking) {
+        int room = mOut.availableForWrite();
+        mRoomKnown |= room > 0;
+        if (mRoomKnown && room < (int)mLineLength) {
+            return false;
+        }
+    }
+    mOut.write(mLine, mLineLength);
+    mLineLength = 0;
+    return true;
+}
+
+void smLog::formatBinary(const smLogRecord& r) {
+    uint32_t fields[2] = { r.id | ((uint32_t)r.argc << 16), r.time };
+    mLine[0] = SM_LOG_SYNC;
+    for (uint8_t i = 0; i < 3; i++) {
+        mLine[1 + i] = (uint8_t)(fields[0] >> (8 * i));
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        mLine[4 + i] = (uint8_t)(fields[1] >> (8 * i));
+    }
+    for (uint8_t a = 0; a < r.argc; a++) {
+        for (uint8_t i = 0; i < 4; i++) {
+            mLine[8 + 4 * a + i] = (uint8_t)((uint32_t)r.args[a] >> (8 * i));
+        }
+    }
+    mLineLength = (uint8_t)(8 + 4 * r.argc);
+}
+
+// Print into a fixed buffer, dropping what does not fit
+class smLogLine : public Print {
+public:
+    smLogLine(uint8_t* aBuffer, uint8_t aSize) : mBuffer(aBuffer), mSize(aSize), mLength(0) {}
+
+    size_t write(uint8_t c) override {
+        if (mLength == mSize) {
+            return 0;
+        }
+        mBuffer[mLength++] = c;
+        return 1;
+    }
+    using Print::write;
+
+    uint8_t getLength() { return mLength; }
+
+private:
+    uint8_t* mBuffer;
+    uint8_t mSize;
+    uint8_t mLength;
+};
+
+static const char* smLogExitName(int32_t code) {
+    switch (code) {
+        case EXIT_NONE:     return "EXIT_NONE";
+        case EXIT_COMPLETE: return "EXIT_COMPLETE";
+        case EXIT_TIMEOUT:  return "EXIT_TIMEOUT";
+        case EXIT_ERROR:    return "EXIT_ERROR";
+        case EXIT_CANCEL:   return "EXIT_CANCEL";
+        case EXIT_ABORT:    return "EXIT_ABORT";
+        default:            return nullptr;
+    }
+}
+
+// "<ms>.<us> " then the expanded format, one line per record
+void smLog::formatText(const smLogRecord& r) {
+    smLogLine out(mLine, SM_LOG_LINE_SIZE - 2);
+    out.print((unsigned long)(r.time / 1000));
+    out.print('.');
+    unsigned int us = r.time % 1000;
+    if (us < 100) out.print('0');
+    if (us < 10) out.print('0');
+    out.print(us);
+    out.print(' ');
+
+    if (r.id == SM_LOG_DROPPED_ID) {
+        out.print("[smLog: ");
+        out.print((long)r.args[0]);
+        out.print(" dropped]");
+    } else if (r.id >= mNumFormats || !mFormats) {
+        // No format table: ID and raw arguments
+        out.print('#');
+        out.print((unsigned int)r.id);
+        for (uint8_t i = 0; i < r.argc; i++) {
+            out.print(' ');
+            out.print((long)r.args[i]);
+        }
+    } else {
+        uint8_t arg = 0;
+        for (const char* f = mFormats[r.id]; *f; f++) {
+            if (*f != '%' || !f[1]) {
+                out.print(*f);
+                continue;
+            }
+            char c = *++f;
+            if (c == '%' || !strchr("duxcSE", c)) {
+                out.print('%');
+                if (c != '%') out.print(c);
+                continue;
+            }
+            if (arg >= r.argc) {
+                out.print('?');
+                continue;
+            }
+            int32_t v = r.args[arg++];
+            switch (c) {
+                case 'd':
+                    out.print((long)v);
+                    break;
+                case 'u':
+                    out.print((unsigned long)(uint32_t)v);
+                    break;
+                case 'x':
+                    out.print((unsigned long)(uint32_t)v, HEX);
+                    break;
+                case 'c':
+                    out.print((char)v);
+                    break;
+                case 'S':
+                    if (mStates && v >= 0 && v < (int32_t)mNumStates && mStates[v]) {
+                        out.print(mStates[v]->getName());
+                    } else {
+                        out.print('#');
+                        out.print((long)v);
+                    }
+                    break;
+                case 'E': {
+                    const char* name = smLogExitName(v);
+                    if (name) {
+                        out.print(name);
+                    } else if (v >= EXIT_USER) {
+                        out.print("EXIT_USER+");
+                        out.print((long)(v - EXIT_USER));
+                    } else {
+                        out.print((long)v);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    mLineLength = out.getLength();
+    mLine[mLineLength++] = '\r';
+    mLine[mLineLength++] = '\n';
+}
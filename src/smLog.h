@@ -0,0 +1,148 @@
+#pragma once
+
+#include "smState.h"
+#include "smQueue.h"
+
+// =============================================================================
+// smLog - Deferred binary logging
+// =============================================================================
+// write() stores a fixed-size record (format ID, SM_LOG_CLOCK() timestamp,
+// up to SM_LOG_ARGS integer arguments) in an smQueue and returns: constant
+// time, no formatting, safe from ISRs and other tasks. The log is itself a
+// Task; each run formats or encodes at most `batch` records to its output,
+// so printing happens between states instead of inside a transition. A
+// run also stops at the first record the output has no room for
+// (Print::availableForWrite()), so a saturated UART drops records instead
+// of stalling the loop; setNonBlocking(false) waits for the output instead.
+// An output that has never reported room (Print's default of 0) is written
+// to blocking.
+//
+//   const char* const logFormats[] = {       // format ID = array index
+//       "enter %S",
+//       "exit %S (%E)",
+//       "blink interval=%u ms",
+//   };
+//   smLog smlog(Serial);
+//
+//   smlog.setFormats(logFormats, 3);         // text output only
+//   smlog.setStates(states, NUM_STATES);     // names for %S
+//   fsm.getScheduler().addTask(smlog);
+//   smlog.enable();
+//
+//   smlog.write(1, getIndex(), getExitCode());
+//
+// Conversions: %d %u %x %c, %S state index (name from setStates()),
+// %E exit code name, %% a percent sign.
+//
+// Binary output (setBinary(true)) writes each record as
+//
+//   0xA5, format ID (uint16), arg count (uint8), timestamp (uint32),
+//   args (int32 each), little-endian
+//
+// and needs no format table on the device; extras/tools/smlog_decode.py
+// expands the IDs on the host. Records rejected because the queue was full
+// are counted (getDropped()) and reported in the output as they are noticed:
+// in binary as format ID 0xFFFF with the number dropped as its argument.
+// =============================================================================
+
+// Queue capacity in records (power of two)
+#ifndef SM_LOG_SIZE
+#define SM_LOG_SIZE             16
+#endif
+
+// Integer arguments per record
+#ifndef SM_LOG_ARGS
+#define SM_LOG_ARGS             3
+#endif
+
+// Record timestamp (text output prints it as milliseconds.microseconds)
+#ifndef SM_LOG_CLOCK
+#define SM_LOG_CLOCK()          micros()
+#endif
+
+// Longest text line, line end included (longer lines are cut). Keep it
+// below the UART TX buffer size, or a non-blocking run never has room.
+#ifndef SM_LOG_LINE_SIZE
+#define SM_LOG_LINE_SIZE        48
+#endif
+
+// Drain task defaults: run interval (ms) and records per run
+#define SM_LOG_INTERVAL_MS      10
+#define SM_LOG_BATCH            4
+
+#define SM_LOG_SYNC             0xA5
+#define SM_LOG_DROPPED_ID       0xFFFF
+
+static_assert(SM_LOG_LINE_SIZE >= 8 + 4 * SM_LOG_ARGS && SM_LOG_LINE_SIZE <= 255,
+              "smLog: SM_LOG_LINE_SIZE must hold a binary record");
+
+struct smLogRecord {
+    uint32_t time;
+    uint16_t id;
+    uint8_t argc;
+    int32_t args[SM_LOG_ARGS];
+};
+
+class smLog : public Task {
+public:
+    smLog(Print& aOut, unsigned long aInterval = SM_LOG_INTERVAL_MS);
+
+    // Producer side: queue a record; false (and counted) if the queue is full
+    template <typename... A>
+    bool write(uint16_t id, A... args) {
+        static_assert(sizeof...(A) <= SM_LOG_ARGS, "smLog: more arguments than SM_LOG_ARGS");
+        const int32_t values[] = { 0, (int32_t)args... };
+        smLogRecord r;
+        r.time = (uint32_t)SM_LOG_CLOCK();
+        r.id = id;
+        r.argc = sizeof...(A);
+        for (uint8_t i = 0; i < sizeof...(A); i++) {
+            r.args[i] = values[i + 1];
+        }
+        return mQueue.push(r);
+    }
+
+    // Output options
+    void setBinary(bool binary) { mBinary = binary; }
+    bool isBinary() { return mBinary; }
+    void setFormats(const char* const* formats, uint16_t count) { mFormats = formats; mNumFormats = count; }
+    void setStates(smState* states[], smIndex_t count) { mStates = states; mNumStates = count; }
+    void setBatch(uint8_t batch) { mBatch = batch ? batch : 1; }
+    void setNonBlocking(bool nonBlocking) { mNonBlocking = nonBlocking; }   // default true
+    bool isNonBlocking() { return mNonBlocking; }
+
+    // Write out everything queued now (e.g. before a reset or deep sleep)
+    void flush();
+
+    // Records rejected because the queue was full, and records taken out
+    unsigned long getDropped() { return mQueue.getOverflowCount(); }
+    unsigned long getDrained() { return mDrained; }
+    static unsigned int capacity() { return SM_LOG_SIZE; }
+
+    // Drain task
+    bool Callback() override;
+
+private:
+    bool drain(uint8_t limit);
+    bool nextRecord(smLogRecord& r);
+    bool writeLine();
+    void formatBinary(const smLogRecord& r);
+    void formatText(const smLogRecord& r);
+
+    Print& mOut;
+    smQueue<smLogRecord, SM_LOG_SIZE> mQueue;
+    const char* const* mFormats;
+    uint16_t mNumFormats;
+    smState** mStates;
+    smIndex_t mNumStates;
+    uint8_t mBatch;
+    bool mBinary;
+    bool mNonBlocking;
+    bool mRoomKnown;            // the output has reported room at least once
+    unsigned long mDrained;
+    unsigned long mReported;
+
+    // Formatted record waiting for room in the output
+    uint8_t mLine[SM_LOG_LINE_SIZE];
+    uint8_t mLineLength;
+};
@@ -1,10 +1,10 @@
 #include "smMachine.h"
 
-smMachine* _smMachineInstance = nullptr;
-
-smMachine::smMachine(smState* aStates[], uint8_t aNumStates,
-                     smTransition* aTransitions, uint8_t aNumTransitions)
-    : mStates(aStates)
+smMachine::smMachine(smState* aStates[], smIndex_t aNumStates,
+                     smTransition* aTransitions, smIndex_t aNumTransitions,
+                     Scheduler* aScheduler)
+    : mScheduler(aScheduler ? aScheduler : &mOwnScheduler)
+    , mStates(aStates)
     , mTransitions(aTransitions)
     , mNumStates(aNumStates)
     , mNumTransitions(aNumTransitions)
@@ -12,56 +12,420 @@ smMachine::smMachine(smState* aStates[], uint8_t aNumStates,
     , mPreviousState(nullptr)
     , mRunning(false)
     , mTransitionCount(0)
+    , mTableSignature(0)
+    , mAsyncStartup(false)
+    , mStarting(false)
+    , mStartState(nullptr)
+    , mStartupBegin(0)
+    , mStartupTime(0)
+    , mRunToCompletion(false)
+    , mHasPending(false)
+    , mPendingExit(EXIT_NONE)
+    , mPendingTarget(nullptr)
+    , mPendingRow(SM_NO_INDEX)
+    , mDispatchDepth(0)
+    , mCoalescedCount(0)
+    , mDroppedCount(0)
+#if SM_FLIGHT_RECORDER_SIZE > 0
+    , mRecorder(mRecorderBuffer, SM_FLIGHT_RECORDER_SIZE)
+#endif
+    , mLastRow(SM_NO_INDEX)
+#ifdef SM_TRANSITION_COUNTERS
+    , mRowHits(nullptr)
+    , mScanOrder(nullptr)
+    , mScanGroups(nullptr)
+#endif
+#ifdef SM_LATENCY_HISTOGRAM
+    , mLatencyPending(false)
+    , mLatencyStart(0)
+    , mLatencyRow(SM_NO_INDEX)
+    , mRowLatency(nullptr)
+#endif
+    , mWheel(nullptr)
+    , mGroup(&smDefaultGroup)
+    , mNextActive(nullptr)
+    , mActive(false)
+    , mParent(nullptr)
+    , mFirstRegion(nullptr)
+    , mNextRegion(nullptr)
+    , mRegionStart(nullptr)
+    , mRetired(nullptr)
+    , mNumRetired(0)
+    , mOwner(nullptr)
+    , mComposite(nullptr)
+    , mActiveChild(nullptr)
+    , mBubbles(nullptr)
+    , mNumBubbles(0)
+    , mBubbleOther{ EXIT_NONE, SM_NO_INDEX, nullptr }
+    , mIndexed(false)
+    , mHasWildcards(false)
+    , mIndex(nullptr)
+    , mIndexStart(nullptr)
+    , mCodeMin(0)
+    , mCodeSpan(0)
+    , mAnyCodeRow(nullptr)
+    , mAnyStateRow(nullptr)
+    , mAnyStateMin(0)
+    , mAnyStateSpan(0)
+    , mDefaultRow(SM_NO_INDEX)
+#ifdef SM_TRANSITION_GUARDS
+    , mNextRow(nullptr)
+#ifdef SM_PROFILING
+    , mGuardStats(nullptr)
+#endif
+#endif
+    , mIndexSize(0)
 {
-    _smMachineInstance = this;
+}
+
+smMachine::~smMachine() {
+    if (mGroup) {
+        mGroup->remove(*this);
+    }
+    if (mParent) {
+        for (smMachine** link = &mParent->mFirstRegion; *link; link = &(*link)->mNextRegion) {
+            if (*link == this) {
+                *link = mNextRegion;
+                break;
+            }
+        }
+    }
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        region->mParent = nullptr;
+    }
+    // A running child's owner is still in its composite state
+    if (mOwner && mRunning && mOwner->mActiveChild == this) {
+        mOwner->mActiveChild = nullptr;
+    }
+    if (mActiveChild) {
+        mActiveChild->mOwner = nullptr;
+    }
+    delete[] mRetired;
+    delete[] mBubbles;
+    freeIndex();
+#if defined(SM_TRANSITION_GUARDS) && defined(SM_PROFILING)
+    delete[] mGuardStats;
+#endif
+#ifdef SM_TRANSITION_COUNTERS
+    delete[] mRowHits;
+    delete[] mScanOrder;
+    delete[] mScanGroups;
+#endif
+#ifdef SM_LATENCY_HISTOGRAM
+    delete[] mRowLatency;
+#endif
 }
 
 bool smMachine::begin() {
     bool ok = true;
 
-    for (uint8_t i = 0; i < mNumStates; i++) {
+    for (smIndex_t i = 0; i < mNumStates; i++) {
         if (mStates[i]) {
+            mStates[i]->setIndex(i);
             mStates[i]->setMachine(this);
             if (mStates[i]->getAction()) {
                 mStates[i]->getAction()->setMachine(this);
             }
-            mScheduler.addTask(*mStates[i]);
+            if (!isOnDemand()) {
+                mScheduler->addTask(*mStates[i]);
+            }
             ok &= mStates[i]->begin();
         }
     }
 
+    buildIndex();
+    mTableSignature = computeTableSignature();
+    if (mOwner && !buildBubbles()) {
+        ok = false;
+    }
+    if (isOnDemand() && !mRetired && mNumStates) {
+        mRetired = new smState*[mNumStates];
+    }
+    mNumRetired = 0;
+#if SM_FLIGHT_RECORDER_SIZE > 0
+    mRecorder.clear();
+#endif
+#if defined(SM_TRANSITION_GUARDS) && defined(SM_PROFILING)
+    delete[] mGuardStats;
+    mGuardStats = nullptr;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        if (mTransitions[i].guard) {
+            mGuardStats = new smGuardStats[mNumTransitions];
+            if (mGuardStats) {
+                memset(mGuardStats, 0, (size_t)mNumTransitions * sizeof(smGuardStats));
+            }
+            break;
+        }
+    }
+#endif
+#ifdef SM_TRANSITION_COUNTERS
+    if (!mRowHits && mNumTransitions) {
+        mRowHits = new uint32_t[mNumTransitions];
+    }
+    resetHits();
+    if (mScanOrder) {
+        reorder();
+    }
+#endif
+#ifdef SM_LATENCY_HISTOGRAM
+    // One histogram per row; without the memory only the machine-wide one
+    if (!mRowLatency && mNumTransitions) {
+        mRowLatency = new smHistogram[mNumTransitions];
+    }
+    resetLatency();
+#endif
+
+    // Regions' devices warm up along with this machine's
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        region->mScheduler = mScheduler;
+        if (!region->mWheel) {
+            region->mWheel = mWheel;
+        }
+        region->mAsyncStartup = true;
+        ok &= region->begin();
+    }
+
+    // Devices that reported smSTARTING warm up together
+    mStartupBegin = millis();
+    mStarting = true;
+    if (!mAsyncStartup) {
+        while (pollStartup()) {
+            yield();
+        }
+    } else if (pollStartup() && mGroup) {
+        mGroup->activate(this);
+    }
+
     return ok;
 }
 
+bool smMachine::pollStartup() {
+    bool starting = false;
+    for (smIndex_t i = 0; i < mNumStates; i++) {
+        if (mStates[i] && mStates[i]->getAction()) {
+            starting |= mStates[i]->getAction()->pollStartup();
+        }
+    }
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        if (region->mStarting) {
+            starting |= region->pollStartup();
+        }
+    }
+    if (!starting) {
+        mStarting = false;
+        mStartupTime = millis() - mStartupBegin;
+        if (mStartState) {
+            smState* state = mStartState;
+            mStartState = nullptr;
+            start(state);
+        }
+    }
+    return starting;
+}
+
 bool smMachine::start(smState* initialState) {
+    if (mStarting) {
+        // Deferred until the devices are ready
+        mStartState = initialState;
+        return initialState != nullptr;
+    }
+    if (!initialState && !mFirstRegion) {
+        return false;
+    }
+#if SM_EVENT_QUEUE_SIZE > 0
+    // Events posted while stopped do not apply to the new run
+    mEvents.clear();
+#endif
+    mHasPending = false;
+    cancelLatency();
+    mRunning = true;
     if (initialState) {
         mCurrentState = initialState;
+        beginDispatch();
+        schedule(mCurrentState);
         mCurrentState->enable();
-        mRunning = true;
-        return true;
+        endDispatch();
     }
-    return false;
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        region->start(region->mRegionStart);
+    }
+    if (mGroup) {
+        mGroup->activate(this);
+    }
+    return true;
 }
 
 void smMachine::stop() {
+    mStartState = nullptr;
+    // In run-to-completion mode, exits requested by onExit() are discarded
+    mDispatchDepth++;
     if (mCurrentState) {
         mCurrentState->disable();
+        retire(mCurrentState);
     }
+    mDispatchDepth--;
+    mHasPending = false;
+    cancelLatency();
     mRunning = false;
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        region->stop();
+    }
 }
 
-void smMachine::execute() {
+unsigned long smMachine::execute() {
+    if (mStarting) {
+        pollStartup();
+    }
     if (mRunning) {
-        mScheduler.execute();
+        dispatchEvents();
+        mScheduler->execute();
     }
+    return getTimeToNextRun();
 }
 
-void smMachine::requestTransition(uint8_t exitCode) {
-    smState* nextState = findNextState(mCurrentState, exitCode);
+unsigned long smMachine::getTimeToNextRun() {
+    if (mStarting) {
+        return SM_DEFAULT_INTERVAL_MS;
+    }
+    if (!mRunning) {
+        return SM_SLEEP_FOREVER;
+    }
+    unsigned long next = SM_SLEEP_FOREVER;
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        unsigned long t = region->getTimeToNextRun();
+        if (t < next) next = t;
+    }
+    if (mActiveChild) {
+        unsigned long t = mActiveChild->getTimeToNextRun();
+        if (t < next) next = t;
+    }
+    if (!mCurrentState) {
+        return next;
+    }
+#if SM_EVENT_QUEUE_SIZE > 0
+    if (!mEvents.isEmpty()) {
+        return 0;
+    }
+#endif
+    long own = mScheduler->timeUntilNextIteration(*mCurrentState);
+    if (own < 0) {
+        own = SM_SLEEP_FOREVER;
+    }
+#ifdef _TASK_TIMEOUT
+    // The timeout fires on the first pass after it has fully elapsed
+    long timeout = mCurrentState->untilTimeout();
+    if (mCurrentState->getTimeout() && timeout + 1 < own) {
+        own = timeout < 0 ? 0 : timeout + 1;
+    }
+#endif
+    // On a timer wheel, once the wheel's Task runs at its expiry
+    smTimer& timer = mCurrentState->getTimer();
+    if (timer.isArmed() && (long)timer.getRemaining() < own) {
+        own = (long)timer.getRemaining();
+    }
+    return (unsigned long)own < next ? (unsigned long)own : next;
+}
+
+void smMachine::dispatchEvents() {
+    sweep();
+#if SM_EVENT_QUEUE_SIZE > 0
+    // At most one queue's worth per call, so a busy producer cannot
+    // starve the scheduler
+    smExitCode_t exitCode;
+    for (unsigned int n = 0; n < SM_EVENT_QUEUE_SIZE && mRunning && mEvents.pop(exitCode); n++) {
+        smAction* action = mCurrentState ? mCurrentState->getAction() : nullptr;
+        if (exitCode == EXIT_NONE) {
+            signal();
+        } else if (action) {
+            action->requestExit(exitCode);
+        } else {
+            requestTransition(exitCode);
+        }
+    }
+#endif
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        region->dispatchEvents();
+    }
+    if (mActiveChild) {
+        mActiveChild->dispatchEvents();
+    }
+}
+
+void smMachine::request(smExitCode_t exitCode, smState* target, smIndex_t row) {
+    if (target && mCurrentState && mCurrentState->getAction()) {
+        // Bubbled up: the composite state exits as if its action asked
+        mCurrentState->getAction()->setExitCode(exitCode);
+    }
+    if (mRunToCompletion) {
+        // Record the request; the first one in a step wins
+        if (mHasPending) {
+            if (exitCode == mPendingExit) {
+                mCoalescedCount++;
+            } else {
+                mDroppedCount++;
+            }
+            return;
+        }
+        mPendingExit = exitCode;
+        mPendingTarget = target;
+        mPendingRow = row;
+        mHasPending = true;
+        startLatency();
+        if (mDispatchDepth == 0) {
+            processPending();
+        }
+        return;
+    }
+    startLatency();
+    applyTransition(exitCode, target, row);
+}
+
+void smMachine::processPending() {
+    // Apply recorded exits one at a time; exits requested while applying
+    // one (onExit, onEnter, timeout) become the next micro-step
+    mDispatchDepth++;
+    for (uint8_t step = 0; mHasPending; step++) {
+        if (step >= SM_MAX_MICROSTEPS) {
+            mHasPending = false;
+            mDroppedCount++;
+            break;
+        }
+        smExitCode_t exitCode = mPendingExit;
+        mHasPending = false;
+        if (mCurrentState && mCurrentState->getAction()) {
+            mCurrentState->getAction()->setExitCode(exitCode);
+        }
+        applyTransition(exitCode, mPendingTarget, mPendingRow);
+    }
+    mDispatchDepth--;
+}
+
+void smMachine::applyTransition(smExitCode_t exitCode, smState* target, smIndex_t row) {
+    mLastRow = row;
+    smState* nextState = target ? target : findNextState(mCurrentState, exitCode);
 
     if (nextState) {
+        record(exitCode, nextState, 0);
+#ifdef SM_LATENCY_HISTOGRAM
+        mLatencyRow = mLastRow;
+#endif
+#ifdef SM_TRANSITION_COUNTERS
+        if (mRowHits && mLastRow != SM_NO_INDEX && mRowHits[mLastRow] != 0xFFFFFFFFUL) {
+            mRowHits[mLastRow]++;
+        }
+#endif
         transitionTo(nextState);
+#ifdef SM_TRANSITION_COUNTERS
+        if (SM_REORDER_INTERVAL && mScanOrder && (mTransitionCount & (SM_REORDER_INTERVAL - 1)) == 0) {
+            reorder();
+        }
+#endif
     } else {
+        cancelLatency();
+        if (mOwner && bubble(exitCode)) {
+            return;
+        }
+        record(exitCode, nullptr, SM_RECORD_INVALID);
         if (mCurrentState && mCurrentState->getAction()) {
             mCurrentState->getAction()->onInvalidTransition(exitCode);
         } else {
@@ -70,14 +434,345 @@ void smMachine::requestTransition(uint8_t exitCode) {
     }
 }
 
-smState* smMachine::findNextState(smState* fromState, uint8_t exitCode) {
-    for (uint8_t i = 0; i < mNumTransitions; i++) {
-        if (mTransitions[i].fromState == fromState &&
-            mTransitions[i].exitCondition == exitCode) {
-            return mTransitions[i].toState;
+smState* smMachine::findNextState(smState* fromState, smExitCode_t exitCode) {
+    smIndex_t row = findRow(fromState, exitCode);
+    mLastRow = row;
+    return row != SM_NO_INDEX ? mTransitions[row].toState : nullptr;
+}
+
+smIndex_t smMachine::findRow(smState* fromState, smExitCode_t exitCode) {
+    if (!fromState) {
+        return SM_NO_INDEX;
+    }
+    if (!mIndexed || !ownsState(fromState)) {
+        return scanRows(fromState, exitCode);
+    }
+
+    smIndex_t s = fromState->getIndex();
+    smIndex_t row = firstPassing(findExactRow(s, exitCode), fromState, exitCode);
+    if (row != SM_NO_INDEX || !mHasWildcards) {
+        return row;
+    }
+
+    // Wildcards, in precedence order
+    if (mAnyCodeRow) {
+        row = firstPassing(mAnyCodeRow[s], fromState, exitCode);
+        if (row != SM_NO_INDEX) {
+            return row;
+        }
+    }
+    if (mAnyStateRow) {
+        if (exitCode >= mAnyStateMin && (smExitCode_t)(exitCode - mAnyStateMin) < mAnyStateSpan) {
+            row = firstPassing(mAnyStateRow[exitCode - mAnyStateMin], fromState, exitCode);
+        }
+    } else if (mAnyStateSpan) {
+        // {SM_ANY_STATE, code} codes too sparse for a table
+        for (smIndex_t i = 0; i < mNumTransitions && row == SM_NO_INDEX; i++) {
+            if (mTransitions[i].fromState == SM_ANY_STATE && mTransitions[i].exitCondition == exitCode &&
+                passesGuard(i, fromState, exitCode)) {
+                row = i;
+            }
         }
     }
-    return nullptr;
+    return row != SM_NO_INDEX ? row : firstPassing(mDefaultRow, fromState, exitCode);
+}
+
+smIndex_t smMachine::findExactRow(smIndex_t s, smExitCode_t exitCode) {
+    if (!mIndex) {
+        return SM_NO_INDEX;
+    }
+
+    if (!mIndexStart) {
+        // Dense: one cell per {state, exitCode}
+        if (exitCode < mCodeMin || (smExitCode_t)(exitCode - mCodeMin) >= mCodeSpan) {
+            return SM_NO_INDEX;
+        }
+        smIndex_t cell = mIndex[(size_t)s * mCodeSpan + (exitCode - mCodeMin)];
+        return cell ? cell - 1 : SM_NO_INDEX;
+    }
+
+    // Ranges: lower bound on the exit code within the state's rows,
+    // so the first matching row in table order wins
+    smIndex_t lo = mIndexStart[s];
+    smIndex_t hi = mIndexStart[s + 1];
+    while (lo < hi) {
+        smIndex_t mid = lo + (hi - lo) / 2;
+        if (mTransitions[mIndex[mid]].exitCondition < exitCode) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < mIndexStart[s + 1] && mTransitions[mIndex[lo]].exitCondition == exitCode) {
+        return mIndex[lo];
+    }
+    return SM_NO_INDEX;
+}
+
+smIndex_t smMachine::scanRows(smState* fromState, smExitCode_t exitCode) {
+    // Linear scan (SM_LINEAR_LOOKUP, or state not part of this machine):
+    // one pass, keeping the first row of the best precedence level seen
+    // (guards are only called on rows that would improve on it); rows that
+    // can tie keep their table order in a frequency-ordered scan
+    smIndex_t best = SM_NO_INDEX;
+    uint8_t bestLevel = 4;
+    for (smIndex_t n = 0; n < mNumTransitions; n++) {
+#ifdef SM_TRANSITION_COUNTERS
+        smIndex_t i = mScanOrder ? mScanOrder[n] : n;
+#else
+        smIndex_t i = n;
+#endif
+        const smTransition& t = mTransitions[i];
+        uint8_t level;
+        if (t.fromState == fromState) {
+            if (t.exitCondition == exitCode) {
+                if (passesGuard(i, fromState, exitCode)) {
+                    return i;
+                }
+                continue;
+            }
+            if (t.exitCondition != EXIT_ANY) {
+                continue;
+            }
+            level = 1;
+        } else if (t.fromState == SM_ANY_STATE) {
+            if (t.exitCondition == exitCode) {
+                level = 2;
+            } else if (t.exitCondition == EXIT_ANY) {
+                level = 3;
+            } else {
+                continue;
+            }
+        } else {
+            continue;
+        }
+        if (level < bestLevel && passesGuard(i, fromState, exitCode)) {
+            best = i;
+            bestLevel = level;
+        }
+    }
+    return best;
+}
+
+void smMachine::buildIndex() {
+    freeIndex();
+#ifndef SM_LINEAR_LOOKUP
+    if (!mTransitions || mNumTransitions == 0 || mNumStates == 0) {
+        return;
+    }
+
+    if (!buildWildcards() || !buildCandidates()) {
+        freeIndex();
+        return;
+    }
+    mIndexed = true;
+
+    // Exit code range of exact rows leaving a state of this machine
+    smExitCode_t codeMin = (smExitCode_t)~(smExitCode_t)0;
+    smExitCode_t codeMax = 0;
+    smIndex_t numIndexed = 0;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        if (isExactRow(i)) {
+            smExitCode_t code = mTransitions[i].exitCondition;
+            if (code < codeMin) codeMin = code;
+            if (code > codeMax) codeMax = code;
+            numIndexed++;
+        }
+    }
+    if (numIndexed == 0) {
+        return;
+    }
+
+    // Cells are sizeof(smIndex_t) bytes; compare before multiplying so wide
+    // exit codes cannot overflow the size
+    const size_t maxCells = SM_INDEX_DENSE_MAX_BYTES / sizeof(smIndex_t);
+    if ((smExitCode_t)(codeMax - codeMin) < maxCells &&
+        (size_t)mNumStates * ((size_t)(codeMax - codeMin) + 1) <= maxCells) {
+        size_t span = (size_t)(codeMax - codeMin) + 1;
+        size_t denseCells = (size_t)mNumStates * span;
+        mIndex = new smIndex_t[denseCells];
+        if (!mIndex) {
+            freeIndex();
+            return;
+        }
+        memset(mIndex, 0, denseCells * sizeof(smIndex_t));
+        mCodeMin = codeMin;
+        mCodeSpan = span;
+        // Walk rows in table order and keep the first match per cell
+        for (smIndex_t i = 0; i < mNumTransitions; i++) {
+            smState* from = mTransitions[i].fromState;
+            if (isExactRow(i)) {
+                smIndex_t* cell = &mIndex[(size_t)from->getIndex() * span +
+                                          (mTransitions[i].exitCondition - codeMin)];
+                if (*cell == 0) {
+                    *cell = i + 1;
+                }
+            }
+        }
+        mIndexSize += denseCells * sizeof(smIndex_t);
+        return;
+    }
+
+    // Too sparse for a dense table: sort row numbers by {state, code, row}
+    mIndex = new smIndex_t[numIndexed];
+    mIndexStart = new smIndex_t[(size_t)mNumStates + 1];
+    if (!mIndex || !mIndexStart) {
+        freeIndex();
+        return;
+    }
+    memset(mIndexStart, 0, ((size_t)mNumStates + 1) * sizeof(smIndex_t));
+
+    // Counting pass per state, then stable insertion by exit code
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        if (isExactRow(i)) {
+            mIndexStart[mTransitions[i].fromState->getIndex() + 1]++;
+        }
+    }
+    for (smIndex_t s = 0; s < mNumStates; s++) {
+        mIndexStart[s + 1] += mIndexStart[s];
+    }
+    for (smIndex_t s = 0; s < mNumStates; s++) {
+        smIndex_t end = mIndexStart[s];
+        for (smIndex_t i = 0; i < mNumTransitions; i++) {
+            if (!isExactRow(i) || mTransitions[i].fromState->getIndex() != s) {
+                continue;
+            }
+            smExitCode_t code = mTransitions[i].exitCondition;
+            smIndex_t j = end++;
+            while (j > mIndexStart[s] && mTransitions[mIndex[j - 1]].exitCondition > code) {
+                mIndex[j] = mIndex[j - 1];
+                j--;
+            }
+            mIndex[j] = i;
+        }
+    }
+    mIndexSize += ((size_t)numIndexed + mNumStates + 1) * sizeof(smIndex_t);
+#endif
+}
+
+bool smMachine::buildWildcards() {
+    // {state, EXIT_ANY}: first row per state
+    // {SM_ANY_STATE, code}: first row per code, dense when it fits
+    // {SM_ANY_STATE, EXIT_ANY}: first such row
+    smExitCode_t codeMin = (smExitCode_t)~(smExitCode_t)0;
+    smExitCode_t codeMax = 0;
+    bool anyCode = false;
+    bool anyState = false;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        const smTransition& t = mTransitions[i];
+        if (t.fromState == SM_ANY_STATE) {
+            if (t.exitCondition == EXIT_ANY) {
+                if (mDefaultRow == SM_NO_INDEX) {
+                    mDefaultRow = i;
+                }
+            } else {
+                if (t.exitCondition < codeMin) codeMin = t.exitCondition;
+                if (t.exitCondition > codeMax) codeMax = t.exitCondition;
+                anyState = true;
+            }
+        } else if (t.exitCondition == EXIT_ANY && ownsState(t.fromState)) {
+            anyCode = true;
+        }
+    }
+    mHasWildcards = anyCode || anyState || mDefaultRow != SM_NO_INDEX;
+
+    if (anyCode) {
+        mAnyCodeRow = new smIndex_t[mNumStates];
+        if (!mAnyCodeRow) {
+            return false;
+        }
+        for (smIndex_t s = 0; s < mNumStates; s++) {
+            mAnyCodeRow[s] = SM_NO_INDEX;
+        }
+        for (smIndex_t i = 0; i < mNumTransitions; i++) {
+            const smTransition& t = mTransitions[i];
+            if (t.exitCondition == EXIT_ANY && ownsState(t.fromState) &&
+                mAnyCodeRow[t.fromState->getIndex()] == SM_NO_INDEX) {
+                mAnyCodeRow[t.fromState->getIndex()] = i;
+            }
+        }
+        mIndexSize += (size_t)mNumStates * sizeof(smIndex_t);
+    }
+
+    if (anyState) {
+        // Codes too sparse for the table are found by scanning those rows
+        mAnyStateMin = codeMin;
+        mAnyStateSpan = (size_t)(codeMax - codeMin) + 1;
+        if ((smExitCode_t)(codeMax - codeMin) < SM_INDEX_DENSE_MAX_BYTES / sizeof(smIndex_t)) {
+            mAnyStateRow = new smIndex_t[mAnyStateSpan];
+            if (!mAnyStateRow) {
+                return false;
+            }
+            for (size_t c = 0; c < mAnyStateSpan; c++) {
+                mAnyStateRow[c] = SM_NO_INDEX;
+            }
+            for (smIndex_t i = 0; i < mNumTransitions; i++) {
+                const smTransition& t = mTransitions[i];
+                if (t.fromState == SM_ANY_STATE && t.exitCondition != EXIT_ANY &&
+                    mAnyStateRow[t.exitCondition - codeMin] == SM_NO_INDEX) {
+                    mAnyStateRow[t.exitCondition - codeMin] = i;
+                }
+            }
+            mIndexSize += mAnyStateSpan * sizeof(smIndex_t);
+        }
+    }
+    return true;
+}
+
+bool smMachine::buildCandidates() {
+#ifdef SM_TRANSITION_GUARDS
+    // Links are only followed from a row whose guard rejected, so only
+    // guarded rows need one
+    bool guarded = false;
+    for (smIndex_t i = 0; i < mNumTransitions && !guarded; i++) {
+        guarded = mTransitions[i].guard != nullptr;
+    }
+    if (!guarded) {
+        return true;
+    }
+    mNextRow = new smIndex_t[mNumTransitions];
+    if (!mNextRow) {
+        return false;
+    }
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        mNextRow[i] = SM_NO_INDEX;
+        if (!mTransitions[i].guard) {
+            continue;
+        }
+        for (smIndex_t j = i + 1; j < mNumTransitions; j++) {
+            if (mTransitions[j].fromState == mTransitions[i].fromState &&
+                mTransitions[j].exitCondition == mTransitions[i].exitCondition) {
+                mNextRow[i] = j;
+                break;
+            }
+        }
+    }
+    mIndexSize += (size_t)mNumTransitions * sizeof(smIndex_t);
+#endif
+    return true;
+}
+
+void smMachine::freeIndex() {
+#ifdef SM_TRANSITION_GUARDS
+    delete[] mNextRow;
+    mNextRow = nullptr;
+#endif
+    delete[] mIndex;
+    delete[] mIndexStart;
+    delete[] mAnyCodeRow;
+    delete[] mAnyStateRow;
+    mIndex = nullptr;
+    mIndexStart = nullptr;
+    mAnyCodeRow = nullptr;
+    mAnyStateRow = nullptr;
+    mIndexed = false;
+    mHasWildcards = false;
+    mCodeMin = 0;
+    mCodeSpan = 0;
+    mAnyStateMin = 0;
+    mAnyStateSpan = 0;
+    mDefaultRow = SM_NO_INDEX;
+    mIndexSize = 0;
 }
 
 void smMachine::transitionTo(smState* toState) {
@@ -92,27 +787,587 @@ void smMachine::transitionTo(smState* toState) {
     // Disable current state (triggers onExit)
     if (mCurrentState) {
         mCurrentState->disable();
+        retire(mCurrentState);
     }
 
     // Enable new state (triggers onEnter)
     mCurrentState = toState;
+    schedule(mCurrentState);
     mCurrentState->enable();
 
     // Increment transition counter
     mTransitionCount++;
 }
 
+bool smMachine::addRegion(smMachine& region, smState* initialState) {
+    if (&region == this || region.mParent || region.mFirstRegion || mParent) {
+        return false;
+    }
+    if (region.mGroup) {
+        region.mGroup->remove(region);
+    }
+    region.mScheduler = mScheduler;
+    region.mParent = this;
+    region.mRegionStart = initialState;
+    smMachine** link = &mFirstRegion;
+    while (*link) {
+        link = &(*link)->mNextRegion;
+    }
+    *link = &region;
+    return true;
+}
+
+void smMachine::retire(smState* state) {
+    if (!mRetired) {
+        // Out of memory: the state stays in the chain, disabled
+        return;
+    }
+    for (smIndex_t i = 0; i < mNumRetired; i++) {
+        if (mRetired[i] == state) {
+            return;
+        }
+    }
+    if (mNumRetired < mNumStates) {
+        mRetired[mNumRetired++] = state;
+    }
+}
+
+void smMachine::sweep() {
+    for (smIndex_t i = 0; i < mNumRetired; i++) {
+        // A stopped machine keeps its last state as current, off the chain
+        if (mRetired[i] != mCurrentState || !mRunning) {
+            mScheduler->deleteTask(*mRetired[i]);
+        }
+    }
+    mNumRetired = 0;
+}
+
+uint8_t smMachine::getNumRegions() {
+    uint8_t n = 0;
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        n++;
+    }
+    return n;
+}
+
+smMachine* smMachine::getRegion(uint8_t i) {
+    smMachine* region = mFirstRegion;
+    while (region && i--) {
+        region = region->mNextRegion;
+    }
+    return region;
+}
+
+uint8_t smMachine::broadcast(smExitCode_t exitCode) {
+    uint8_t n = offer(exitCode) ? 1 : 0;
+    for (smMachine* region = mFirstRegion; region; region = region->mNextRegion) {
+        if (region->offer(exitCode)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+bool smMachine::offer(smExitCode_t exitCode) {
+    if (!mRunning || !mCurrentState || !findNextState(mCurrentState, exitCode)) {
+        return false;
+    }
+    smAction* action = mCurrentState->getAction();
+    if (action) {
+        action->requestExit(exitCode);
+    } else {
+        requestTransition(exitCode);
+    }
+    return true;
+}
+
+// Exit codes this machine cannot resolve, offered to its ancestors' rows
+// for their composite states: one binary search in the bubble table
+bool smMachine::bubble(smExitCode_t exitCode) {
+    if (mOwner->mActiveChild != this) {
+        return false;
+    }
+    const smBubble* b = &mBubbleOther;
+    size_t lo = 0;
+    size_t hi = mNumBubbles;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (mBubbles[mid].code < exitCode) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < mNumBubbles && mBubbles[lo].code == exitCode) {
+        b = &mBubbles[lo];
+    }
+    if (b->row != SM_NO_INDEX) {
+        b->owner->request(exitCode, b->owner->mTransitions[b->row].toState, b->row);
+        return true;
+    }
+
+    // Guarded rows, lookups without a table, or no table memory: ask each
+    // ancestor from there up
+    for (smMachine* m = b->owner; m; m = m->mOwner) {
+        m->mLastRow = SM_NO_INDEX;
+        smState* next = m->findNextState(m->mCurrentState, exitCode);
+        if (next) {
+            m->request(exitCode, next, m->mLastRow);
+            return true;
+        }
+        if (m->mOwner && m->mOwner->mActiveChild != m) {
+            break;
+        }
+    }
+    return false;
+}
+
+// Flatten the bubble path: every exit code with a row of its own in an
+// ancestor (for the composite state, or SM_ANY_STATE) gets an entry unless
+// it resolves like all other codes (mBubbleOther)
+bool smMachine::buildBubbles() {
+    delete[] mBubbles;
+    mBubbles = nullptr;
+    mNumBubbles = 0;
+    // Without memory every code is resolved level by level
+    mBubbleOther = { EXIT_NONE, SM_NO_INDEX, mOwner };
+
+    size_t numRows = 0;
+    for (smMachine* m = mOwner; m; m = m->mOwner) {
+        numRows += m->mNumTransitions;
+    }
+    smExitCode_t* codes = numRows ? new smExitCode_t[numRows] : nullptr;
+    if (numRows && !codes) {
+        return false;
+    }
+
+    // Sorted, without duplicates
+    size_t numCodes = 0;
+    for (smMachine* c = this; c->mOwner; c = c->mOwner) {
+        smMachine* m = c->mOwner;
+        for (smIndex_t i = 0; i < m->mNumTransitions; i++) {
+            const smTransition& t = m->mTransitions[i];
+            if ((t.fromState != c->mComposite && t.fromState != SM_ANY_STATE) || t.exitCondition == EXIT_ANY) {
+                continue;
+            }
+            size_t j = numCodes;
+            while (j > 0 && codes[j - 1] > t.exitCondition) {
+                j--;
+            }
+            if (j > 0 && codes[j - 1] == t.exitCondition) {
+                continue;
+            }
+            memmove(&codes[j + 1], &codes[j], (numCodes - j) * sizeof(smExitCode_t));
+            codes[j] = t.exitCondition;
+            numCodes++;
+        }
+    }
+
+    bool ok = true;
+    mBubbles = numCodes ? new smBubble[numCodes] : nullptr;
+    if (numCodes && !mBubbles) {
+        ok = false;
+    } else {
+        mBubbleOther = resolveBubble(EXIT_ANY);
+        for (size_t i = 0; i < numCodes; i++) {
+            smBubble b = resolveBubble(codes[i]);
+            if (b.owner != mBubbleOther.owner || b.row != mBubbleOther.row) {
+                mBubbles[mNumBubbles++] = b;
+            }
+        }
+        if (!mNumBubbles) {
+            delete[] mBubbles;
+            mBubbles = nullptr;
+        }
+        mIndexSize += mNumBubbles * sizeof(smBubble);
+    }
+    delete[] codes;
+    return ok;
+}
+
+// Nearest ancestor whose row for its composite state takes `exitCode`
+// (EXIT_ANY: a code without rows of its own)
+smMachine::smBubble smMachine::resolveBubble(smExitCode_t exitCode) {
+    smBubble b = { exitCode, SM_NO_INDEX, nullptr };
+    for (smMachine* c = this; c->mOwner; c = c->mOwner) {
+        smMachine* m = c->mOwner;
+        if (!m->mTransitions) {
+            // Lookup without a table (smStaticMachine): resolved at runtime
+            b.owner = m;
+            return b;
+        }
+        smIndex_t row = m->firstRow(c->mComposite, exitCode);
+        if (row != SM_NO_INDEX) {
+            b.owner = m;
+#ifdef SM_TRANSITION_GUARDS
+            // A guard may reject the row: resolved at runtime from here up
+            if (m->mTransitions[row].guard) {
+                return b;
+            }
+#endif
+            b.row = row;
+            return b;
+        }
+    }
+    return b;
+}
+
+// Row findRow() tries first for {fromState, exitCode}, guards not called
+// (EXIT_ANY rows rank as exact rows for exitCode EXIT_ANY, keeping their
+// order against {SM_ANY_STATE, EXIT_ANY})
+smIndex_t smMachine::firstRow(smState* fromState, smExitCode_t exitCode) {
+    smIndex_t best = SM_NO_INDEX;
+    uint8_t bestLevel = 4;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        const smTransition& t = mTransitions[i];
+        uint8_t level;
+        if (t.fromState == fromState) {
+            level = t.exitCondition == exitCode ? 0 : t.exitCondition == EXIT_ANY ? 1 : 4;
+        } else if (t.fromState == SM_ANY_STATE) {
+            level = t.exitCondition == exitCode ? 2 : t.exitCondition == EXIT_ANY ? 3 : 4;
+        } else {
+            continue;
+        }
+        if (level < bestLevel) {
+            best = i;
+            bestLevel = level;
+        }
+    }
+    return best;
+}
+
 void smMachine::forceTransitionTo(smState* toState) {
+    beginDispatch();
+    cancelLatency();
+    record(EXIT_NONE, toState, toState ? SM_RECORD_FORCED : SM_RECORD_FORCED | SM_RECORD_INVALID);
     transitionTo(toState);
+    endDispatch();
+}
+
+uint16_t smMachine::computeTableSignature() {
+    uint16_t crc = smSnapshot::crc16(0xFFFF, mNumStates);
+    crc = smSnapshot::crc16(crc, mNumTransitions);
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        const smTransition& t = mTransitions[i];
+        crc = smSnapshot::crc16(crc, ownsState(t.fromState) ? t.fromState->getIndex() : SM_NO_INDEX);
+        crc = smSnapshot::crc16(crc, t.exitCondition);
+        crc = smSnapshot::crc16(crc, ownsState(t.toState) ? t.toState->getIndex() : SM_NO_INDEX);
+    }
+    return crc;
+}
+
+size_t smMachine::saveSnapshot(uint8_t* buffer, size_t size) {
+    if (!mRunning || !ownsState(mCurrentState) || !buffer || size < SM_SNAPSHOT_SIZE(0)) {
+        return 0;
+    }
+
+    // Payload first, straight into place
+    size_t room = size - SM_SNAPSHOT_SIZE(0);
+    if (room > SM_SNAPSHOT_MAX_PAYLOAD) {
+        room = SM_SNAPSHOT_MAX_PAYLOAD;
+    }
+    smAction* action = mCurrentState->getAction();
+    size_t len = action ? action->onSave(buffer + SM_SNAPSHOT_PAYLOAD_OFFSET, room) : 0;
+    if (len > room) {
+        return 0;
+    }
+
+    bool hasPrevious = ownsState(mPreviousState);
+    smAction* previous = hasPrevious ? mPreviousState->getAction() : nullptr;
+    uint8_t* p = buffer;
+    *p++ = 'S';
+    *p++ = 'M';
+    *p++ = 'S';
+    *p++ = 'N';
+    *p++ = SM_SNAPSHOT_VERSION;
+    *p++ = sizeof(smIndex_t);
+    *p++ = sizeof(smExitCode_t);
+    *p++ = (uint8_t)len;
+    p = smSnapshot::put(p, mTableSignature);
+    p = smSnapshot::put(p, mCurrentState->getIndex());
+    p = smSnapshot::put(p, hasPrevious ? mPreviousState->getIndex() : SM_NO_INDEX);
+    p = smSnapshot::put(p, action ? action->getExitCode() : (smExitCode_t)EXIT_NONE);
+    p = smSnapshot::put(p, previous ? previous->getExitCode() : (smExitCode_t)EXIT_NONE);
+    p = smSnapshot::put(p, (uint32_t)(millis() - mCurrentState->getEnterTime()));
+    p = smSnapshot::put(p, (uint32_t)mTransitionCount);
+    p += len;
+    smSnapshot::put(p, smSnapshot::crc16(buffer, (size_t)(p - buffer)));
+    return SM_SNAPSHOT_SIZE(len);
+}
+
+bool smMachine::restoreSnapshot(const uint8_t* buffer, size_t size) {
+    if (mRunning || !buffer || size < SM_SNAPSHOT_SIZE(0)) {
+        return false;
+    }
+    const uint8_t* p = buffer;
+    if (p[0] != 'S' || p[1] != 'M' || p[2] != 'S' || p[3] != 'N' || p[4] != SM_SNAPSHOT_VERSION ||
+        p[5] != sizeof(smIndex_t) || p[6] != sizeof(smExitCode_t)) {
+        return false;
+    }
+    size_t len = p[7];
+    size_t total = SM_SNAPSHOT_SIZE(len);
+    if (size < total) {
+        return false;
+    }
+    uint16_t crc;
+    smSnapshot::get(buffer + total - 2, crc);
+    if (crc != smSnapshot::crc16(buffer, total - 2)) {
+        return false;
+    }
+
+    uint16_t signature;
+    smIndex_t current, previous;
+    smExitCode_t currentExit, previousExit;
+    uint32_t elapsed, count;
+    p = smSnapshot::get(p + 8, signature);
+    p = smSnapshot::get(p, current);
+    p = smSnapshot::get(p, previous);
+    p = smSnapshot::get(p, currentExit);
+    p = smSnapshot::get(p, previousExit);
+    p = smSnapshot::get(p, elapsed);
+    p = smSnapshot::get(p, count);
+    // Same table as saved, and begun (states know their index)
+    if (signature != mTableSignature || current >= mNumStates || !mStates[current] ||
+        mStates[current]->getIndex() != current ||
+        (previous != SM_NO_INDEX && (previous >= mNumStates || !mStates[previous]))) {
+        return false;
+    }
+
+    smState* state = mStates[current];
+    smAction* action = state->getAction();
+    if (action && !action->onRestore(p, len)) {
+        return false;
+    }
+
+#if SM_EVENT_QUEUE_SIZE > 0
+    mEvents.clear();
+#endif
+    mHasPending = false;
+    mPreviousState = previous != SM_NO_INDEX ? mStates[previous] : nullptr;
+    if (mPreviousState && mPreviousState->getAction()) {
+        mPreviousState->getAction()->setExitCode(previousExit);
+    }
+    mTransitionCount = count;
+    mCurrentState = nullptr;
+    record(EXIT_NONE, state, SM_RECORD_FORCED);
+
+    mCurrentState = state;
+    beginDispatch();
+    schedule(state);
+    state->resume(elapsed);
+    if (action) {
+        action->setExitCode(currentExit);
+    }
+    mRunning = true;
+    endDispatch();
+    if (mGroup) {
+        mGroup->activate(this);
+    }
+    return true;
+}
+
+#ifdef SM_PROFILING
+bool smMachine::getStateStats(smIndex_t index, smStateStats& stats) {
+    if (index >= mNumStates || !mStates[index]) {
+        return false;
+    }
+    mStates[index]->getStats(stats);
+    return true;
+}
+
+void smMachine::resetStats() {
+    for (smIndex_t i = 0; i < mNumStates; i++) {
+        if (mStates[i]) {
+            mStates[i]->resetStats();
+        }
+    }
+#ifdef SM_TRANSITION_GUARDS
+    if (mGuardStats) {
+        memset(mGuardStats, 0, (size_t)mNumTransitions * sizeof(smGuardStats));
+    }
+#endif
+}
+
+#ifdef SM_TRANSITION_GUARDS
+bool smMachine::getGuardStats(smIndex_t row, smGuardStats& stats) {
+    if (!mGuardStats || row >= mNumTransitions || !mTransitions[row].guard) {
+        return false;
+    }
+    stats = mGuardStats[row];
+    return true;
+}
+#endif
+#endif
+
+#ifdef SM_TRANSITION_COUNTERS
+void smMachine::resetHits() {
+    if (mRowHits) {
+        memset(mRowHits, 0, (size_t)mNumTransitions * sizeof(uint32_t));
+    }
+}
+
+static size_t smPrintName(Print& out, smState* state) {
+    if (!state) {
+        return out.print('*');
+    }
+    return out.print(state->getName() ? state->getName() : "?");
 }
 
-void smMachine::onInvalidTransition(smState* fromState, uint8_t exitCode) {
+size_t smMachine::dumpHeatmap(Print& out) {
+    const uint8_t barWidth = 20;
+    uint32_t hottest = 0;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        if (getRowHits(i) > hottest) {
+            hottest = getRowHits(i);
+        }
+    }
+    size_t n = 0;
+    for (smIndex_t i = 0; i < mNumTransitions; i++) {
+        const smTransition& t = mTransitions[i];
+        uint32_t hits = getRowHits(i);
+        n += out.print((unsigned long)i);
+        n += out.print(' ');
+        n += smPrintName(out, t.fromState);
+        n += out.print(' ');
+        if (t.exitCondition == EXIT_ANY) {
+            n += out.print('*');
+        } else {
+            n += out.print((unsigned long)t.exitCondition);
+        }
+        n += out.print(' ');
+        n += smPrintName(out, t.toState);
+        n += out.print(' ');
+        n += out.print((unsigned long)hits);
+        n += out.print(' ');
+        uint8_t bar = hottest ? (uint8_t)((uint64_t)hits * barWidth / hottest) : 0;
+        if (hits && !bar) {
+            bar = 1;
+        }
+        for (uint8_t b = 0; b < bar; b++) {
+            n += out.print('#');
+        }
+        n += out.println();
+    }
+    return n;
+}
+
+bool smMachine::setFrequencyOrder(bool enable) {
+    delete[] mScanOrder;
+    delete[] mScanGroups;
+    mScanOrder = nullptr;
+    mScanGroups = nullptr;
+#ifndef SM_LINEAR_LOOKUP
+    // Nothing to gain: the index does not scan
+    if (enable) {
+        return false;
+    }
+#endif
+    if (enable && mNumTransitions) {
+        mScanOrder = new smIndex_t[mNumTransitions];
+        mScanGroups = new smScanGroup[mNumTransitions];
+        if (!mScanOrder || !mScanGroups) {
+            setFrequencyOrder(false);
+            return false;
+        }
+        reorder();
+    }
+    return true;
+}
+
+// Shell sort of row numbers; `before(a, b)` must be a strict total order
+template <typename Before>
+static void smSortRows(smIndex_t* rows, smIndex_t count, Before before) {
+    smIndex_t gap = 1;
+    while (gap < count / 3) {
+        gap = gap * 3 + 1;
+    }
+    for (; gap > 0; gap /= 3) {
+        for (smIndex_t i = gap; i < count; i++) {
+            smIndex_t row = rows[i];
+            smIndex_t j = i;
+            while (j >= gap && before(row, rows[j - gap])) {
+                rows[j] = rows[j - gap];
+                j -= gap;
+            }
+            rows[j] = row;
+        }
+    }
+}
+
+void smMachine::reorder() {
+    if (!mScanOrder || !mScanGroups || !mRowHits) {
+        return;
+    }
+    smIndex_t n = mNumTransitions;
+    // Group rows sharing {fromState, exitCondition}: sorted by key then
+    // row, the first row of each run leads its group
+    for (smIndex_t i = 0; i < n; i++) {
+        mScanOrder[i] = i;
+    }
+    const smTransition* t = mTransitions;
+    smSortRows(mScanOrder, n, [t](smIndex_t a, smIndex_t b) {
+        if (t[a].fromState != t[b].fromState) {
+            return (uintptr_t)t[a].fromState < (uintptr_t)t[b].fromState;
+        }
+        if (t[a].exitCondition != t[b].exitCondition) {
+            return t[a].exitCondition < t[b].exitCondition;
+        }
+        return a < b;
+    });
+    smScanGroup* group = mScanGroups;
+    for (smIndex_t start = 0; start < n;) {
+        smIndex_t first = mScanOrder[start];
+        smIndex_t end = start;
+        uint32_t sum = 0;
+        while (end < n && t[mScanOrder[end]].fromState == t[first].fromState &&
+               t[mScanOrder[end]].exitCondition == t[first].exitCondition) {
+            uint32_t hits = mRowHits[mScanOrder[end]];
+            sum = sum + hits < sum ? 0xFFFFFFFFUL : sum + hits;
+            end++;
+        }
+        for (smIndex_t i = start; i < end; i++) {
+            group[mScanOrder[i]].leader = first;
+            group[mScanOrder[i]].hits = sum;
+        }
+        start = end;
+    }
+    // Hottest group first; a group's rows stay together in table order
+    smSortRows(mScanOrder, n, [group](smIndex_t a, smIndex_t b) {
+        if (group[a].hits != group[b].hits) {
+            return group[a].hits > group[b].hits;
+        }
+        if (group[a].leader != group[b].leader) {
+            return group[a].leader < group[b].leader;
+        }
+        return a < b;
+    });
+}
+#endif
+
+#ifdef SM_LATENCY_HISTOGRAM
+bool smMachine::getLatency(smIndex_t row, smHistogram& histogram) {
+    if (!mRowLatency || row >= mNumTransitions) {
+        return false;
+    }
+    histogram = mRowLatency[row];
+    return true;
+}
+
+void smMachine::resetLatency() {
+    mLatency.clear();
+    if (mRowLatency) {
+        for (smIndex_t i = 0; i < mNumTransitions; i++) {
+            mRowLatency[i].clear();
+        }
+    }
+}
+#endif
+
+void smMachine::onInvalidTransition(smState* fromState, smExitCode_t exitCode) {
     mRunning = false;
 }
 
 // Arduino loop() implementation
 void loop() {
-    if (_smMachineInstance) {
-        _smMachineInstance->execute();
-    }
+    smDefaultGroup.execute();
 }
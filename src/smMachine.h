@@ -2,25 +2,198 @@
 
 #include <TaskSchedulerDeclarations.h>
 #include "smState.h"
+#include "smMachineGroup.h"
+#include "smQueue.h"
+#include "smFlightRecorder.h"
+#include "smSnapshot.h"
+#include "smHistogram.h"
 
+// Transition lookup
+//   By default begin() builds an index over the transition table so that
+//   findNextState() does not scan every row:
+//     - dense:  one cell per {state, exitCode} -> constant-time lookup
+//     - ranges: rows sorted per state, binary search on the exit code
+//   The dense table is used when it fits in SM_INDEX_DENSE_MAX_BYTES,
+//   otherwise the (smaller) ranges index is built.
+//   Define SM_LINEAR_LOOKUP to keep the original table scan (no extra RAM).
+#ifndef SM_INDEX_DENSE_MAX_BYTES
+#if defined(__AVR__)
+#define SM_INDEX_DENSE_MAX_BYTES    128
+#else
+#define SM_INDEX_DENSE_MAX_BYTES    2048
+#endif
+#endif
+
+// Posted transitions (postTransition)
+//   Size of the per-machine queue of exit codes posted from ISRs or other
+//   tasks; must be a power of two, 0 disables posting. Enabled by default
+//   for _TASK_THREAD_SAFE builds. Define it in build flags, not in a sketch,
+//   so the library is compiled with the same value.
+#ifndef SM_EVENT_QUEUE_SIZE
+#ifdef _TASK_THREAD_SAFE
+#define SM_EVENT_QUEUE_SIZE         8
+#else
+#define SM_EVENT_QUEUE_SIZE         0
+#endif
+#endif
+
+// Run-to-completion mode: longest chain of transitions resolved in one step
+#ifndef SM_MAX_MICROSTEPS
+#define SM_MAX_MICROSTEPS           8
+#endif
+
+// Flight recorder: number of recent transitions kept for post-mortem
+// analysis (SM_RECORD_SIZE bytes each, 0 disables). Define it in build
+// flags, not in a sketch, so the library is compiled with the same value.
+#ifndef SM_FLIGHT_RECORDER_SIZE
+#define SM_FLIGHT_RECORDER_SIZE     0
+#endif
+
+// Transition latency (define SM_LATENCY_HISTOGRAM to enable)
+//   Time from requestExit()/requestTransition() to the target action's
+//   onEnter(), including onExit() and any run-to-completion delay, kept in
+//   an smHistogram per machine and per transition row. SM_LATENCY_CLOCK()
+//   is micros() by default. Define it in build flags, not in a sketch.
+#ifdef SM_LATENCY_HISTOGRAM
+#ifndef SM_LATENCY_CLOCK
+#define SM_LATENCY_CLOCK()      micros()
+#endif
+#endif
+
+// Transition counters (define SM_TRANSITION_COUNTERS to enable)
+//   A 32-bit hit counter per transition row (allocated by begin()), a
+//   heatmap dump, and an opt-in frequency order for linear table scans.
+//   Frequency-ordered scans are re-sorted every SM_REORDER_INTERVAL
+//   transitions (a power of two; 0 re-sorts only on reorder()). A re-sort
+//   takes O(n log^2 n) in the number of rows, inside the transition that
+//   triggers it. Define them in build flags.
+#ifndef SM_REORDER_INTERVAL
+#define SM_REORDER_INTERVAL     4096
+#endif
+
+// Wildcard for smTransition::fromState: matches any state of the machine
+#define SM_ANY_STATE                ((smState*)nullptr)
+
+// Transition guards
+//   Define SM_TRANSITION_GUARDS to add an optional guard to smTransition
+//   (one function pointer per row). A row is taken only if its guard is
+//   nullptr or returns true; several rows may share {fromState, exitCode}
+//   and are tried in table order. Guards are called during lookup with the
+//   current state and exit code, so they must not have side effects.
+//   Define it in build flags, not in a sketch.
+typedef bool (*smGuard)(smState* state, smExitCode_t exitCode);
+
+// Guard calling a bool method of the state's action:
+//   { &STATE_IDLE, EXIT_GO, &STATE_RUN, smActionGuard<IdleAction, &IdleAction::isReady> }
+// The state's action must be an A.
+template <typename A, bool (A::*Method)()>
+bool smActionGuard(smState* state, smExitCode_t) {
+    return (static_cast<A*>(state->getAction())->*Method)();
+}
+
+// Guard calling a plain bool function: smGuardFn<isBatteryLow>
+template <bool (*Fn)()>
+bool smGuardFn(smState*, smExitCode_t) {
+    return Fn();
+}
+
+#ifdef SM_PROFILING
+// Guard counters of one transition row (see smMachine::getGuardStats)
+struct smGuardStats {
+    unsigned long evaluations;  // times the guard was called
+    unsigned long passed;       // times it returned true
+};
+#endif
+
+// Transition rows, by precedence when several match:
+//   { state,        code,     to }   exact
+//   { state,        EXIT_ANY, to }   any exit code from that state
+//   { SM_ANY_STATE, code,     to }   that exit code from any state
+//   { SM_ANY_STATE, EXIT_ANY, to }   default fallback
+// Within a level the first row in table order wins, skipping rows whose
+// guard returns false. Rows are built by constructor, so { from, code, to }
+// leaves no member to zero-initialization with or without guards, and a
+// default-constructed row is all null.
 struct smTransition {
     smState* fromState;
-    uint8_t exitCondition;
+    smExitCode_t exitCondition;
     smState* toState;
+#ifdef SM_TRANSITION_GUARDS
+    smGuard guard;
+
+    constexpr smTransition()
+        : fromState(nullptr), exitCondition(EXIT_NONE), toState(nullptr), guard(nullptr) {}
+    constexpr smTransition(smState* aFrom, smExitCode_t aExitCondition, smState* aTo,
+                           smGuard aGuard = nullptr)
+        : fromState(aFrom), exitCondition(aExitCondition), toState(aTo), guard(aGuard) {}
+#else
+    constexpr smTransition()
+        : fromState(nullptr), exitCondition(EXIT_NONE), toState(nullptr) {}
+    constexpr smTransition(smState* aFrom, smExitCode_t aExitCondition, smState* aTo)
+        : fromState(aFrom), exitCondition(aExitCondition), toState(aTo) {}
+#endif
 };
 
 class smMachine {
 public:
-    smMachine(smState* aStates[], uint8_t aNumStates,
-              smTransition* aTransitions, uint8_t aNumTransitions);
+    // aScheduler: share an external scheduler instead of the machine's own
+    smMachine(smState* aStates[], smIndex_t aNumStates,
+              smTransition* aTransitions, smIndex_t aNumTransitions,
+              Scheduler* aScheduler = nullptr);
+    virtual ~smMachine();
 
     bool begin();
     bool start(smState* initialState);
     void stop();
-    void execute();
+
+    // Device start-up
+    //   begin() lets every action begin() its devices, then polls those
+    //   reporting smSTARTING until all are ready, so warm-ups overlap (see
+    //   smDevice::poll). With async start-up, begin() returns at once and
+    //   the devices are polled from execute() instead; start() is deferred
+    //   until every device is ready or past its start-up timeout.
+    void setAsyncStartup(bool enable) { mAsyncStartup = enable; }
+    bool isAsyncStartup() { return mAsyncStartup; }
+    bool isStarting() { return mStarting; }
+
+    // Milliseconds from begin() until every device was ready or timed out
+    // (so far, while starting)
+    unsigned long getStartupTime() { return mStarting ? millis() - mStartupBegin : mStartupTime; }
+
+    // Run one tick; returns the milliseconds until the machine next has work
+    // (see getTimeToNextRun()), so the loop can sleep until then
+    unsigned long execute();
+
+    // Milliseconds until the current state is due to run or time out:
+    // 0 if due now or posted events are waiting, SM_SLEEP_FOREVER if
+    // nothing is scheduled. Application tasks on the machine's scheduler
+    // are not included; use Scheduler::timeUntilNextIteration() for those.
+    unsigned long getTimeToNextRun();
+
+    // Wake the current state (see smState::setEventDriven)
+    void signal() {
+        if (mCurrentState) {
+            mCurrentState->signal();
+        }
+    }
 
     // Request transition from current state with exit code
-    void requestTransition(uint8_t exitCode);
+    void requestTransition(smExitCode_t exitCode) { request(exitCode, nullptr, SM_NO_INDEX); }
+
+#if SM_EVENT_QUEUE_SIZE > 0
+    // Queue a transition request; safe from ISRs and other tasks.
+    // Posted exit codes are applied in posting order at the start of the
+    // next execute(), each to the state current at that moment, as if that
+    // state's action called requestExit(). Returns false if the queue is full.
+    bool postTransition(smExitCode_t exitCode) { return mEvents.push(exitCode); }
+
+    // Queue a signal() to whichever state is current when it is applied;
+    // safe from ISRs (posted as EXIT_NONE)
+    bool postSignal() { return mEvents.push(EXIT_NONE); }
+
+    // Posted transitions rejected because the queue was full
+    unsigned long getQueueOverflowCount() { return mEvents.getOverflowCount(); }
+#endif
 
     // State accessors
     smState* getCurrentState() { return mCurrentState; }
@@ -30,7 +203,48 @@ public:
     bool isRunning() { return mRunning; }
 
     // Get scheduler reference for adding application tasks
-    Scheduler& getScheduler() { return mScheduler; }
+    Scheduler& getScheduler() { return *mScheduler; }
+
+    // Group executing this machine (smDefaultGroup unless moved)
+    smMachineGroup* getGroup() { return mGroup; }
+
+    // Timer wheel for state timeouts (see smTimerWheel), usually shared by
+    // many machines; set before begin(). States then time out from the
+    // wheel instead of the scheduler checking every state's Task timeout
+    // on every pass. Regions and child machines without one use this one.
+    void setTimerWheel(smTimerWheel* wheel) { mWheel = wheel; }
+    smTimerWheel* getTimerWheel() { return mWheel; }
+
+    // Orthogonal regions
+    //   A region is an smMachine of its own (states, transition subset,
+    //   lookup index) attached to this one with addRegion() before
+    //   begin(). It moves onto this machine's scheduler and out of its
+    //   group; this machine's begin(), start(), stop() and execute() then
+    //   drive every region as well, each keeping its own current state.
+    //   start(nullptr) starts only the regions. While regions are attached,
+    //   only current states are kept in the scheduler's task chain, so a
+    //   tick costs O(regions) instead of O(states). Returns false if the
+    //   region already belongs to a machine.
+    bool addRegion(smMachine& region, smState* initialState);
+    uint8_t getNumRegions();
+    smMachine* getRegion(uint8_t i);
+    smMachine* getParent() { return mParent; }
+
+    // Hand `exitCode` to this machine and every region whose current state
+    // has a row for it, as if their actions called requestExit(); the
+    // others ignore it. Returns how many took it.
+    uint8_t broadcast(smExitCode_t exitCode);
+
+    // Hierarchy (see smSubmachine)
+    //   A child machine runs inside a composite state of its owner, on the
+    //   owner's scheduler. An exit code the child's table cannot resolve
+    //   bubbles up to the owner's rows for the composite state, then to the
+    //   owner's owner, before onInvalidTransition() is called. begin()
+    //   flattens that path into one table per child, so a bubbled exit
+    //   costs one binary search however deep the child is nested.
+    smMachine* getOwner() { return mOwner; }
+    smState* getCompositeState() { return mComposite; }
+    smMachine* getActiveChild() { return mActiveChild; }
 
     // Transition counter for diagnostics
     unsigned long getTransitionCount() { return mTransitionCount; }
@@ -38,23 +252,337 @@ public:
     // Force transition to specific state (for fault recovery, etc.)
     void forceTransitionTo(smState* toState);
 
+    // Snapshot / restore (see smSnapshot.h)
+    //   saveSnapshot() writes the running machine into `buffer` (e.g. RTC
+    //   memory before deep sleep) and returns the bytes written, 0 if it
+    //   is not running or the buffer is too small. restoreSnapshot(), called
+    //   after begin() in place of start(), re-enters the saved state without
+    //   its onEnter() and returns false if the snapshot is damaged, from
+    //   other firmware, or rejected by the action's onRestore().
+    size_t saveSnapshot(uint8_t* buffer, size_t size);
+    bool restoreSnapshot(const uint8_t* buffer, size_t size);
+
+    // Run-to-completion mode
+    //   Exits requested from onRun(), onEnter(), onExit() or a timeout are
+    //   recorded and applied once the current callback has returned, instead
+    //   of switching states from inside it. The first exit requested in a step
+    //   wins; exits requested while applying it are resolved as further
+    //   micro-steps, at most SM_MAX_MICROSTEPS per step.
+    void setRunToCompletion(bool enable) { mRunToCompletion = enable; }
+    bool isRunToCompletion() { return mRunToCompletion; }
+
+    // Run-to-completion counters: requests repeating the pending exit code
+    // (coalesced), and requests discarded for a different code or for
+    // exceeding SM_MAX_MICROSTEPS (dropped)
+    unsigned long getCoalescedCount() { return mCoalescedCount; }
+    unsigned long getDroppedCount() { return mDroppedCount; }
+
+    // Bracket a callback into actions (used by smState)
+    void beginDispatch() { mDispatchDepth++; }
+    void endDispatch() {
+        if (--mDispatchDepth == 0 && mHasPending) {
+            processPending();
+        }
+    }
+
+#ifdef SM_PROFILING
+    // Profile snapshot of the state at `index` in the state array
+    // (returns false if there is no such state)
+    bool getStateStats(smIndex_t index, smStateStats& stats);
+    void resetStats();
+
+#ifdef SM_TRANSITION_GUARDS
+    // Guard counters of transition row `row` (returns false if the row
+    // has no guard); cleared by begin() and resetStats()
+    bool getGuardStats(smIndex_t row, smGuardStats& stats);
+#endif
+#endif
+
+#ifdef SM_LATENCY_HISTOGRAM
+    // Copy of the latency histogram, machine-wide or of transition row
+    // `row` (returns false if there is no such row or it was not
+    // allocated); safe to call while the machine runs. Forced transitions
+    // and start() are not measured. Cleared by begin() and resetLatency().
+    void getLatency(smHistogram& histogram) { histogram = mLatency; }
+    bool getLatency(smIndex_t row, smHistogram& histogram);
+    void resetLatency();
+
+    // Latency end point, just before onEnter() (used by smState)
+    void endLatency() {
+        if (mLatencyPending) {
+            unsigned long elapsed = SM_LATENCY_CLOCK() - mLatencyStart;
+            mLatencyPending = false;
+            mLatency.record(elapsed);
+            if (mRowLatency && mLatencyRow != SM_NO_INDEX) {
+                mRowLatency[mLatencyRow].record(elapsed);
+            }
+        }
+    }
+#endif
+
+#ifdef SM_TRANSITION_COUNTERS
+    // Transitions taken through row `row` (saturating; 0 if there is no
+    // such row); cleared by begin() and resetHits()
+    uint32_t getRowHits(smIndex_t row) { return mRowHits && row < mNumTransitions ? mRowHits[row] : 0; }
+    void resetHits();
+
+    // One line per row in table order: row, from state, exit code, to
+    // state, hits and a bar scaled to the hottest row ("*" for wildcards)
+    size_t dumpHeatmap(Print& out);
+
+    // Frequency order (SM_LINEAR_LOOKUP builds): table scans visit rows by
+    // hit count, hottest first, instead of table order. Rows sharing
+    // {fromState, exitCondition} keep their table order, so the row that
+    // wins a lookup is the same. reorder() re-sorts now (e.g. from idle
+    // time); it also runs every SM_REORDER_INTERVAL transitions.
+    // setFrequencyOrder(true) returns false if out of memory, and in
+    // indexed builds, whose lookups do not depend on row position.
+    bool setFrequencyOrder(bool enable);
+    bool isFrequencyOrder() { return mScanOrder != nullptr; }
+    void reorder();
+#endif
+
+#if SM_FLIGHT_RECORDER_SIZE > 0
+    // Most recent transitions, including forced and invalid ones;
+    // cleared by begin()
+    smFlightRecorder& getRecorder() { return mRecorder; }
+#endif
+
+    // Bytes allocated by begin() for the transition lookup index and
+    // bubble table (0 when the table is scanned linearly)
+    size_t getIndexSize() { return mIndexSize; }
+    bool isIndexDense() { return mIndex && !mIndexStart; }
+
+    // Transition table lookup (no side effects)
+    virtual smState* findNextState(smState* fromState, smExitCode_t exitCode);
+
+    // Signature of the transition table, checked by restoreSnapshot();
+    // machines whose table is not mTransitions[] fold theirs in on top
+    virtual uint16_t computeTableSignature();
+
     // Called when transition is invalid and action has no handler
-    virtual void onInvalidTransition(smState* fromState, uint8_t exitCode);
+    virtual void onInvalidTransition(smState* fromState, smExitCode_t exitCode);
 
 private:
+    friend class smMachineGroup;
+    friend class smSubmachine;
+
+    // Bubble table entry: the ancestor and row taking an exit code the
+    // child cannot resolve (see buildBubbles())
+    struct smBubble {
+        smExitCode_t code;
+        smIndex_t row;          // SM_NO_INDEX: resolved at `owner` and up at runtime
+        smMachine* owner;       // nullptr: no ancestor takes it
+    };
+
+    bool pollStartup();
     void transitionTo(smState* toState);
-    smState* findNextState(smState* fromState, uint8_t exitCode);
+    bool offer(smExitCode_t exitCode);
+    bool bubble(smExitCode_t exitCode);
+    bool buildBubbles();
+    smBubble resolveBubble(smExitCode_t exitCode);
+    smIndex_t firstRow(smState* fromState, smExitCode_t exitCode);
+    bool isOnDemand() { return mParent || mFirstRegion || mOwner || mScheduler != &mOwnScheduler; }
+
+    // With regions, in child machines and on a shared scheduler, a state
+    // is only in the task chain while current, so a shared chain holds one
+    // task per running machine. A state left may still be inside its own
+    // callback, so it is retired and taken out of the chain by the next
+    // sweep() (from execute(), or when a group drops the stopped machine).
+    void schedule(smState* state) {
+        if (isOnDemand()) {
+            mScheduler->addTask(*state);
+        }
+    }
+    void retire(smState* state);
+    void sweep();
+    void record(smExitCode_t exitCode, smState* toState, uint16_t flags) {
+#if SM_FLIGHT_RECORDER_SIZE > 0
+        mRecorder.record(ownsState(mCurrentState) ? mCurrentState->getIndex() : SM_NO_INDEX,
+                         exitCode,
+                         ownsState(toState) ? toState->getIndex() : SM_NO_INDEX,
+                         flags);
+#endif
+    }
+    void startLatency() {
+#ifdef SM_LATENCY_HISTOGRAM
+        // The first request wins, like run-to-completion's pending exit
+        if (!mLatencyPending) {
+            mLatencyPending = true;
+            mLatencyStart = SM_LATENCY_CLOCK();
+        }
+#endif
+    }
+    void cancelLatency() {
+#ifdef SM_LATENCY_HISTOGRAM
+        mLatencyPending = false;
+#endif
+    }
+    // A transition request; `target` (row `row`) is already resolved
+    // when bubbled up from a child
+    void request(smExitCode_t exitCode, smState* target, smIndex_t row);
+    void applyTransition(smExitCode_t exitCode, smState* target, smIndex_t row);
+    void processPending();
+    void dispatchEvents();
+    smIndex_t findRow(smState* fromState, smExitCode_t exitCode);
+    smIndex_t findExactRow(smIndex_t state, smExitCode_t exitCode);
+    smIndex_t scanRows(smState* fromState, smExitCode_t exitCode);
+    bool passesGuard(smIndex_t row, smState* state, smExitCode_t exitCode) {
+#ifdef SM_TRANSITION_GUARDS
+        smGuard guard = mTransitions[row].guard;
+        if (!guard) {
+            return true;
+        }
+        bool passed = guard(state, exitCode);
+#ifdef SM_PROFILING
+        if (mGuardStats) {
+            mGuardStats[row].evaluations++;
+            mGuardStats[row].passed += passed;
+        }
+#endif
+        return passed;
+#else
+        return true;
+#endif
+    }
+    // First row from `row` on, along its candidate chain, that passes its guard
+    smIndex_t firstPassing(smIndex_t row, smState* state, smExitCode_t exitCode) {
+#ifdef SM_TRANSITION_GUARDS
+        while (row != SM_NO_INDEX && !passesGuard(row, state, exitCode)) {
+            row = mNextRow[row];
+        }
+#endif
+        return row;
+    }
+    void buildIndex();
+    bool buildWildcards();
+    bool buildCandidates();
+    void freeIndex();
+    bool isExactRow(smIndex_t row) {
+        return mTransitions[row].exitCondition != EXIT_ANY && ownsState(mTransitions[row].fromState);
+    }
+    bool ownsState(smState* state) {
+        return state && state->getIndex() < mNumStates && mStates[state->getIndex()] == state;
+    }
 
-    Scheduler mScheduler;
+    Scheduler mOwnScheduler;
+    Scheduler* mScheduler;
     smState** mStates;
     smTransition* mTransitions;
-    uint8_t mNumStates;
-    uint8_t mNumTransitions;
+    smIndex_t mNumStates;
+    smIndex_t mNumTransitions;
     smState* mCurrentState;
     smState* mPreviousState;
     bool mRunning;
     unsigned long mTransitionCount;
-};
+    uint16_t mTableSignature;   // of the table as begun (snapshots)
 
-// Global machine pointer for loop()
-extern smMachine* _smMachineInstance;
+    // Device start-up (start() deferred to mStartState while starting)
+    bool mAsyncStartup;
+    bool mStarting;
+    smState* mStartState;
+    unsigned long mStartupBegin;
+    unsigned long mStartupTime;
+
+    // Run-to-completion state
+    bool mRunToCompletion;
+    bool mHasPending;
+    smExitCode_t mPendingExit;
+    smState* mPendingTarget;
+    smIndex_t mPendingRow;
+    uint8_t mDispatchDepth;
+    unsigned long mCoalescedCount;
+    unsigned long mDroppedCount;
+
+#if SM_EVENT_QUEUE_SIZE > 0
+    smQueue<smExitCode_t, SM_EVENT_QUEUE_SIZE> mEvents;
+#endif
+
+#if SM_FLIGHT_RECORDER_SIZE > 0
+    uint8_t mRecorderBuffer[SM_FLIGHT_RECORDER_SIZE * SM_RECORD_SIZE];
+    smFlightRecorder mRecorder;
+#endif
+
+    // Row found by the last findNextState() (SM_NO_INDEX if none, or if
+    // findNextState() is overridden)
+    smIndex_t mLastRow;
+
+#ifdef SM_TRANSITION_COUNTERS
+    // mRowHits[row]; mScanOrder lists every row in scan order (nullptr
+    // scans in table order), sorted by the group hits in mScanGroups[row]
+    struct smScanGroup {
+        uint32_t hits;          // hits of every row sharing the row's key
+        smIndex_t leader;       // first of those rows in table order
+    };
+    uint32_t* mRowHits;
+    smIndex_t* mScanOrder;
+    smScanGroup* mScanGroups;
+#endif
+
+#ifdef SM_LATENCY_HISTOGRAM
+    // Request time of the transition in flight and its row;
+    // mRowLatency has one per row
+    bool mLatencyPending;
+    unsigned long mLatencyStart;
+    smIndex_t mLatencyRow;
+    smHistogram mLatency;
+    smHistogram* mRowLatency;
+#endif
+
+    smTimerWheel* mWheel;
+
+    // Group membership (see smMachineGroup)
+    smMachineGroup* mGroup;
+    smMachine* mNextActive;
+    bool mActive;
+
+    // Regions (see addRegion), in the order added
+    smMachine* mParent;
+    smMachine* mFirstRegion;
+    smMachine* mNextRegion;
+    smState* mRegionStart;
+    smState** mRetired;
+    smIndex_t mNumRetired;
+
+    // Hierarchy (see smSubmachine): the owner and its state running this
+    // machine, the child of the current state if it is composite, and the
+    // bubble table sorted by code (other codes take mBubbleOther)
+    smMachine* mOwner;
+    smState* mComposite;
+    smMachine* mActiveChild;
+    smBubble* mBubbles;
+    size_t mNumBubbles;
+    smBubble mBubbleOther;
+
+    // Lookup index (see buildIndex()), exact rows only
+    //   dense:  mIndex[state * mCodeSpan + (code - mCodeMin)] = row + 1, 0 = none
+    //   ranges: mIndex holds row numbers sorted by {state, code},
+    //           mIndexStart[state]..mIndexStart[state + 1] is a state's range
+    bool mIndexed;
+    bool mHasWildcards;
+    smIndex_t* mIndex;
+    smIndex_t* mIndexStart;
+    smExitCode_t mCodeMin;
+    size_t mCodeSpan;
+
+    // Wildcard rows, consulted in this order after an exact miss
+    //   mAnyCodeRow[state]                 {state, EXIT_ANY} row
+    //   mAnyStateRow[code - mAnyStateMin]  {SM_ANY_STATE, code} row
+    //   mDefaultRow                        {SM_ANY_STATE, EXIT_ANY} row
+    smIndex_t* mAnyCodeRow;
+    smIndex_t* mAnyStateRow;
+    smExitCode_t mAnyStateMin;
+    size_t mAnyStateSpan;
+    smIndex_t mDefaultRow;
+
+#ifdef SM_TRANSITION_GUARDS
+    // Candidate chains: mNextRow[row] is the next row with the same
+    // {fromState, exitCondition}, followed when a guard rejects (only
+    // allocated if some row has a guard)
+    smIndex_t* mNextRow;
+#ifdef SM_PROFILING
+    smGuardStats* mGuardStats;
+#endif
+#endif
+    size_t mIndexSize;
+};
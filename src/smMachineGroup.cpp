@@ -0,0 +1,131 @@
+#include "smMachineGroup.h"
+#include "smMachine.h"
+#include "smBus.h"
+
+smMachineGroup smDefaultGroup;
+
+void smMachineGroup::add(smMachine& machine) {
+    if (machine.mGroup == this) {
+        return;
+    }
+    if (machine.mGroup) {
+        machine.mGroup->remove(machine);
+    }
+    machine.mGroup = this;
+    if (machine.isRunning() || machine.isStarting()) {
+        activate(&machine);
+    }
+}
+
+void smMachineGroup::remove(smMachine& machine) {
+    if (machine.mGroup != this) {
+        return;
+    }
+    unlink(&machine);
+    machine.mGroup = nullptr;
+}
+
+void smMachineGroup::add(smBus& bus) {
+    if (bus.mGroup == this) {
+        return;
+    }
+    if (bus.mGroup) {
+        bus.mGroup->remove(bus);
+    }
+    bus.mGroup = this;
+    bus.mNextBus = mFirstBus;
+    mFirstBus = &bus;
+}
+
+void smMachineGroup::remove(smBus& bus) {
+    if (bus.mGroup != this) {
+        return;
+    }
+    for (smBus** link = &mFirstBus; *link; link = &(*link)->mNextBus) {
+        if (*link == &bus) {
+            *link = bus.mNextBus;
+            break;
+        }
+    }
+    bus.mNextBus = nullptr;
+    bus.mGroup = nullptr;
+}
+
+unsigned long smMachineGroup::execute() {
+    bool anyRunning = false;
+    unsigned long next = SM_SLEEP_FOREVER;
+
+    // Buses with events committed since last tick run on this pass
+    for (smBus* bus = mFirstBus; bus; bus = bus->mNextBus) {
+        bus->wake();
+    }
+
+    // Walk running machines, dropping the ones that stopped since last tick
+    smMachine** link = &mFirst;
+    while (*link) {
+        smMachine* machine = *link;
+        if (machine->isRunning() || machine->isStarting()) {
+            anyRunning = true;
+            if (mScheduler && &machine->getScheduler() == mScheduler) {
+                if (machine->isStarting()) {
+                    machine->pollStartup();
+                }
+                machine->dispatchEvents();
+            } else {
+                unsigned long t = machine->execute();
+                if (t < next) next = t;
+            }
+            link = &machine->mNextActive;
+        } else {
+            machine->sweep();
+            *link = machine->mNextActive;
+            machine->mNextActive = nullptr;
+            machine->mActive = false;
+            mActiveCount--;
+        }
+    }
+
+    if (mScheduler && anyRunning) {
+        mScheduler->execute();
+        for (smMachine* machine = mFirst; machine; machine = machine->mNextActive) {
+            unsigned long t = machine->getTimeToNextRun();
+            if (t < next) next = t;
+        }
+    }
+
+    // Committed during this tick (ISRs, subscribers): no sleep before the next
+    for (smBus* bus = mFirstBus; bus && next; bus = bus->mNextBus) {
+        if (bus->isPending()) {
+            next = 0;
+        }
+    }
+
+    if (anyRunning && next && mSleepMethod) {
+        mSleepMethod(next);
+    }
+    return next;
+}
+
+void smMachineGroup::activate(smMachine* machine) {
+    if (!machine->mActive) {
+        machine->mActive = true;
+        machine->mNextActive = mFirst;
+        mFirst = machine;
+        mActiveCount++;
+    }
+}
+
+void smMachineGroup::unlink(smMachine* machine) {
+    if (!machine->mActive) {
+        return;
+    }
+    for (smMachine** link = &mFirst; *link; link = &(*link)->mNextActive) {
+        if (*link == machine) {
+            *link = machine->mNextActive;
+            machine->mNextActive = nullptr;
+            machine->mActive = false;
+            mActiveCount--;
+            return;
+        }
+    }
+}
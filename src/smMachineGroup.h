@@ -0,0 +1,72 @@
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+
+class smMachine;
+class smBus;
+
+// =============================================================================
+// smMachineGroup - Drives any number of machines from one loop
+// =============================================================================
+// Machines join the library's smDefaultGroup when constructed, which the
+// library-provided loop() executes. A group only walks machines that have
+// been started (or are polling device start-up), so a tick costs
+// O(running machines); stopped machines are dropped from the walk lazily.
+//
+// Machines may share one Scheduler: construct them with the scheduler and
+// add them to a group constructed with the same scheduler. The group then
+// runs that scheduler once per tick instead of once per machine; only the
+// current states of running machines are in its chain. A machine on a
+// scheduler of its own is still executed on its own.
+//
+// execute() returns how long until any running machine has work; with a
+// sleep method set, the group calls it with that time so the loop can
+// idle (light sleep, WFI) instead of spinning.
+//
+// smBus instances join smDefaultGroup too. Their Tasks sleep until an
+// event is committed; each tick the group wakes the ones with events
+// queued (commit() may run in an ISR, where the Task cannot be touched),
+// and does not sleep while any are left.
+// =============================================================================
+
+typedef void (*smSleepCallback)(unsigned long aDuration);
+
+class smMachineGroup {
+public:
+    constexpr smMachineGroup(Scheduler* aScheduler = nullptr)
+        : mScheduler(aScheduler), mFirst(nullptr), mFirstBus(nullptr), mActiveCount(0), mSleepMethod(nullptr) {}
+
+    // Move a machine or bus into this group (from its current group, if any)
+    void add(smMachine& machine);
+    void remove(smMachine& machine);
+    void add(smBus& bus);
+    void remove(smBus& bus);
+
+    // Run one tick of every running machine; returns the milliseconds until
+    // the next one has work (SM_SLEEP_FOREVER if none is scheduled)
+    unsigned long execute();
+
+    // Called at the end of a tick with the time returned by execute() when
+    // machines are running but none has work due now
+    void setSleepMethod(smSleepCallback aCallback) { mSleepMethod = aCallback; }
+
+    // Number of machines currently walked by execute()
+    unsigned int getActiveCount() { return mActiveCount; }
+
+    // Shared scheduler (nullptr if every machine runs its own)
+    Scheduler* getScheduler() { return mScheduler; }
+
+private:
+    friend class smMachine;
+    void activate(smMachine* machine);
+    void unlink(smMachine* machine);
+
+    Scheduler* mScheduler;
+    smMachine* mFirst;
+    smBus* mFirstBus;
+    unsigned int mActiveCount;
+    smSleepCallback mSleepMethod;
+};
+
+// Group executed by the library's loop(); machines join it on construction
+extern smMachineGroup smDefaultGroup;
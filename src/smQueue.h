@@ -0,0 +1,137 @@
+#pragma once
+
+#include <Arduino.h>
+
+// =============================================================================
+// smQueue - Bounded lock-free multi-producer / single-consumer ring
+// =============================================================================
+// push() may be called from any number of ISRs or tasks concurrently;
+// pop() must only be called from one consumer (the machine's loop).
+//
+//   - push() and pop() run in constant time; push() is lock-free (a CAS
+//     retry only happens when another producer wins the same slot)
+//   - Capacity N must be a power of two
+//   - A full queue rejects the item and counts it in getOverflowCount()
+//
+// Ordering: items are popped in the order their slots were reserved.
+// Items from one producer are therefore FIFO. An item whose producer was
+// interrupted between reserving and publishing its slot holds back the
+// items queued after it until it is published - nothing is skipped.
+//
+// On AVR (no atomic instructions) each operation runs with interrupts
+// masked for a few cycles instead.
+// =============================================================================
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+template <typename T, unsigned int N>
+class smQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "smQueue: size must be a power of two");
+
+public:
+    smQueue() : mHead(0), mTail(0), mOverflows(0) {
+        for (unsigned int i = 0; i < N; i++) {
+            mCells[i].sequence = i;
+        }
+    }
+
+    // Producer side: safe from ISRs and other tasks
+    bool push(const T& item) {
+#if defined(__AVR__)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            Cell* cell = &mCells[mHead & (N - 1)];
+            if (cell->sequence != mHead) {
+                mOverflows++;
+                return false;
+            }
+            cell->item = item;
+            cell->sequence = ++mHead;
+        }
+        return true;
+#else
+        unsigned int pos = __atomic_load_n(&mHead, __ATOMIC_RELAXED);
+        Cell* cell;
+        for (;;) {
+            cell = &mCells[pos & (N - 1)];
+            unsigned int seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            int diff = (int)(seq - pos);
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&mHead, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                __atomic_fetch_add(&mOverflows, 1, __ATOMIC_RELAXED);
+                return false;
+            } else {
+                pos = __atomic_load_n(&mHead, __ATOMIC_RELAXED);
+            }
+        }
+        cell->item = item;
+        __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+        return true;
+#endif
+    }
+
+    // Consumer side: single consumer only
+    bool pop(T& item) {
+        Cell* cell = &mCells[mTail & (N - 1)];
+#if defined(__AVR__)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (cell->sequence != mTail + 1) {
+                return false;
+            }
+            item = cell->item;
+            cell->sequence = mTail + N;
+            mTail++;
+        }
+        return true;
+#else
+        unsigned int seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        if ((int)(seq - (mTail + 1)) < 0) {
+            return false;
+        }
+        item = cell->item;
+        __atomic_store_n(&cell->sequence, mTail + N, __ATOMIC_RELEASE);
+        mTail++;
+        return true;
+#endif
+    }
+
+    // Consumer side: true if pop() would find nothing right now
+    bool isEmpty() {
+        Cell* cell = &mCells[mTail & (N - 1)];
+#if defined(__AVR__)
+        bool empty;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            empty = cell->sequence != mTail + 1;
+        }
+        return empty;
+#else
+        unsigned int seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        return (int)(seq - (mTail + 1)) < 0;
+#endif
+    }
+
+    // Consumer side: discard everything queued
+    void clear() {
+        T item;
+        while (pop(item)) {}
+    }
+
+    unsigned long getOverflowCount() { return mOverflows; }
+    static unsigned int capacity() { return N; }
+
+private:
+    struct Cell {
+        volatile unsigned int sequence;
+        T item;
+    };
+
+    Cell mCells[N];
+    volatile unsigned int mHead;
+    unsigned int mTail;
+    volatile unsigned long mOverflows;
+};
@@ -0,0 +1,15 @@
+#include "smSnapshot.h"
+
+// One nibble at a time: a 32-byte table instead of eight shifts per byte
+static const uint16_t smCrcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t smSnapshot::crc16(const uint8_t* data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 4) ^ smCrcNibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ smCrcNibble[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
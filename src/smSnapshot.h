@@ -0,0 +1,65 @@
+#pragma once
+
+#include "smState.h"
+
+// =============================================================================
+// smSnapshot - Binary snapshot of a running machine (smMachine::saveSnapshot)
+// =============================================================================
+// For resuming after deep sleep from RTC memory instead of replaying the
+// start-up sequence. Little-endian fields (24 bytes plus payload with the
+// default 8-bit SM_INDEX_WIDTH and SM_EXIT_WIDTH):
+//
+//   "SMSN", version (1), index bytes, exit code bytes, payload length,
+//   table signature (uint16), current state index, previous state index
+//   (SM_NO_INDEX if none), current action's exit code, previous action's
+//   exit code, ms already spent in the current state (uint32), transition
+//   count (uint32), action payload, CRC-16 of all preceding bytes (uint16)
+//
+// The table signature is a CRC of the state count and transition table, so
+// a snapshot taken by different firmware is rejected instead of resuming
+// into the wrong state.
+// =============================================================================
+
+#define SM_SNAPSHOT_VERSION         1
+
+// Longest payload an action can add (onSave)
+#define SM_SNAPSHOT_MAX_PAYLOAD     255
+
+// Bytes needed for a snapshot carrying `payload` bytes of action data:
+//   RTC_DATA_ATTR uint8_t rtcSnapshot[SM_SNAPSHOT_SIZE(8)];
+#define SM_SNAPSHOT_SIZE(payload)   (20 + 2 * (SM_INDEX_WIDTH + SM_EXIT_WIDTH) / 8 + (payload))
+
+// Offset of the payload within a snapshot
+#define SM_SNAPSHOT_PAYLOAD_OFFSET  (SM_SNAPSHOT_SIZE(0) - 2)
+
+class smSnapshot {
+public:
+    // CRC-16/CCITT-FALSE, chainable through `crc`
+    static uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+    // Little-endian field access
+    template <typename T>
+    static uint8_t* put(uint8_t* p, T value) {
+        for (uint8_t i = 0; i < sizeof(T); i++) {
+            *p++ = (uint8_t)(value >> (8 * i));
+        }
+        return p;
+    }
+
+    template <typename T>
+    static const uint8_t* get(const uint8_t* p, T& value) {
+        value = 0;
+        for (uint8_t i = 0; i < sizeof(T); i++) {
+            value |= (T)((T)*p++ << (8 * i));
+        }
+        return p;
+    }
+
+    // Feed a field into a running CRC
+    template <typename T>
+    static uint16_t crc16(uint16_t crc, T value) {
+        uint8_t bytes[sizeof(T)];
+        put(bytes, value);
+        return crc16(bytes, sizeof(T), crc);
+    }
+};
@@ -7,7 +7,20 @@ smState::smState(smAction* aAction, const char* name, unsigned long aInterval, l
     , mMachine(nullptr)
     , mName(name)
     , mEnterTime(0)
+    , mIndex(SM_NO_INDEX)
+    , mEventDriven(false)
+    , mResuming(false)
+    , mAdaptive(false)
+    , mDeviceStarting(false)
+    , mMinInterval(aInterval)
+    , mMaxInterval(aInterval)
+    , mWheelTimeout(0)
+    , mFullTimeout(0)
+    , mTimer(onTimeout, this)
 {
+#ifdef SM_PROFILING
+    resetStats();
+#endif
 }
 
 bool smState::begin() {
@@ -24,23 +37,144 @@ void smState::end() {
     }
 }
 
+void smState::setAdaptiveInterval(unsigned long minInterval, unsigned long maxInterval) {
+    mAdaptive = maxInterval > minInterval;
+    mMinInterval = minInterval;
+    mMaxInterval = mAdaptive ? maxInterval : minInterval;
+    setInterval(minInterval);
+}
+
 bool smState::OnEnable() {
     mEnterTime = millis();
+    if (mAdaptive) {
+        setInterval(mMinInterval);
+    }
+#ifdef _TASK_TIMEOUT
+    if (mFullTimeout && !mResuming) {
+        setTimeout(mFullTimeout);
+        mFullTimeout = 0;
+    }
+#endif
+    armTimeout(0);
+#ifdef SM_PROFILING
+    mStats.entries++;
+#endif
     if (mAction) {
-        mAction->resetExitCode();
-        mAction->onEnter();
+        mAction->useDevices();
+        // A lazy device begun just now may start asynchronously: poll it
+        // from this state's runs (see Callback)
+        mDeviceStarting = mAction->pollStartup();
+        if (!mResuming) {
+            if (mMachine) mMachine->beginDispatch();
+#ifdef SM_LATENCY_HISTOGRAM
+            if (mMachine) mMachine->endLatency();
+#endif
+            mAction->resetExitCode();
+            mAction->onEnter();
+            if (mMachine) mMachine->endDispatch();
+        }
     }
     return true;
 }
 
+void smState::resume(unsigned long elapsed) {
+#ifdef _TASK_TIMEOUT
+    // enable() restarts a scheduler timeout in full: give this visit only
+    // the time that was left (the full one is back at the next entry)
+    bool onWheel = mMachine && mMachine->getTimerWheel();
+    unsigned long timeout = mFullTimeout ? mFullTimeout : getTimeout();
+    if (!onWheel && timeout) {
+        mFullTimeout = timeout;
+        setTimeout(timeout > elapsed ? timeout - elapsed : 1);
+    }
+#endif
+    mResuming = true;
+    enable();
+    mResuming = false;
+    mEnterTime = millis() - elapsed;
+    if (mTimer.isArmed()) {
+        armTimeout(elapsed);
+    }
+}
+
+void smState::armTimeout(unsigned long elapsed) {
+    smTimerWheel* wheel = mMachine ? mMachine->getTimerWheel() : nullptr;
+    if (!wheel) {
+        return;
+    }
+#ifdef _TASK_TIMEOUT
+    // The wheel replaces the scheduler's per-pass timeout check
+    if (getTimeout()) {
+        mWheelTimeout = getTimeout();
+        setTimeout(TASK_NOTIMEOUT);
+    }
+#endif
+    if (mWheelTimeout) {
+        wheel->arm(mTimer, mWheelTimeout > elapsed ? mWheelTimeout - elapsed : 0);
+    }
+}
+
+void smState::onTimeout(smTimer&, void* state) {
+    smState* self = static_cast<smState*>(state);
+    if (!self->mMachine || !self->isEnabled()) {
+        return;
+    }
+    // As a scheduler timeout would, unless an exit was already requested
+    if (self->mAction && self->mAction->getExitCode() == EXIT_NONE) {
+        self->mAction->requestExit(EXIT_TIMEOUT);
+    }
+}
+
 bool smState::Callback() {
+    // Go back to sleep first, so a signal() or re-entry during onRun()
+    // still schedules the next run (an event-driven state keeps its
+    // interval while a device it began is starting)
+    if (mAction && mDeviceStarting) {
+        mDeviceStarting = mAction->pollStartup();
+    }
+    if (mEventDriven && !mDeviceStarting) {
+        delay(SM_SLEEP_FOREVER);
+    }
     if (mAction) {
-        return mAction->onRun();
+        if (!mMachine) {
+            return mAction->onRun();
+        }
+        mMachine->beginDispatch();
+#ifdef SM_PROFILING
+        unsigned long start = SM_PROFILE_CLOCK();
+        bool didWork = mAction->onRun();
+        unsigned long elapsed = SM_PROFILE_CLOCK() - start;
+        mStats.runCount++;
+        mStats.runTime += elapsed;
+        if (elapsed > mStats.runTimeMax) {
+            mStats.runTimeMax = elapsed;
+        }
+#else
+        bool didWork = mAction->onRun();
+#endif
+        mMachine->endDispatch();
+        // Back off while idle, snap back on work (unless onRun() left the state)
+        if (mAdaptive && !mEventDriven && isEnabled()) {
+            unsigned long interval = getInterval();
+            unsigned long next = didWork ? mMinInterval
+                               : interval >= mMaxInterval / 2 ? mMaxInterval
+                               : interval ? interval * 2 : 1;
+            if (next != interval) {
+                setInterval(next);
+            }
+        }
+        return didWork;
     }
     return false;
 }
 
 void smState::OnDisable() {
+    mTimer.cancel();
+#ifdef SM_PROFILING
+    mStats.exits++;
+    mStats.dwellTime += millis() - mEnterTime;
+#endif
+    if (mMachine) mMachine->beginDispatch();
     if (mAction) {
         mAction->onExit();
     }
@@ -49,4 +183,23 @@ void smState::OnDisable() {
     if (timedOut() && mMachine && mAction && mAction->getExitCode() == EXIT_NONE) {
         mMachine->requestTransition(EXIT_TIMEOUT);
     }
+    if (mMachine) mMachine->endDispatch();
+}
+
+#ifdef SM_PROFILING
+void smState::getStats(smStateStats& stats) {
+    stats = mStats;
+    stats.interval = getInterval();
+    if (isEnabled()) {
+        stats.dwellTime += millis() - mEnterTime;
+    }
+}
+
+void smState::resetStats() {
+    memset(&mStats, 0, sizeof(mStats));
+    if (isEnabled()) {
+        // Count the current visit from now on (wraps back when it is added)
+        mStats.dwellTime = mEnterTime - millis();
+    }
 }
+#endif
@@ -7,10 +7,62 @@
 
 #include <TaskSchedulerDeclarations.h>
 #include "smAction.h"
+#include "smTimerWheel.h"
 
 // Default state execution interval (milliseconds)
 #define SM_DEFAULT_INTERVAL_MS  1
 
+// Delay an event-driven state sleeps for between wake-ups; also returned
+// by smMachine::execute() when nothing is scheduled
+#define SM_SLEEP_FOREVER        0x7FFFFFFFUL
+
+// State and transition index width in bits (8, 16 or 32)
+//   Limits a machine to 2^width - 1 states and transitions; 8 bits keeps
+//   the lookup index and flight recorder compact on small parts. Define it
+//   in build flags, not in a sketch, so the library sees the same value.
+#ifndef SM_INDEX_WIDTH
+#define SM_INDEX_WIDTH          8
+#endif
+
+#if SM_INDEX_WIDTH == 8
+typedef uint8_t smIndex_t;
+#elif SM_INDEX_WIDTH == 16
+typedef uint16_t smIndex_t;
+#elif SM_INDEX_WIDTH == 32
+typedef uint32_t smIndex_t;
+#else
+#error "SM_INDEX_WIDTH must be 8, 16 or 32"
+#endif
+
+// Index value for states not registered with a machine (and "no row")
+#define SM_NO_INDEX             ((smIndex_t)~(smIndex_t)0)
+
+// Profiling (define SM_PROFILING to enable; compiles out otherwise)
+//   SM_PROFILE_CLOCK() times onRun(): micros() by default, the CPU cycle
+//   counter on ESP32. Define it to use another time base.
+#ifdef SM_PROFILING
+#ifndef SM_PROFILE_CLOCK
+#if defined(ARDUINO_ARCH_ESP32)
+#define SM_PROFILE_CLOCK()      ESP.getCycleCount()
+#else
+#define SM_PROFILE_CLOCK()      micros()
+#endif
+#endif
+#endif
+
+// Per-state profile snapshot (see smMachine::getStateStats)
+struct smStateStats {
+    unsigned long runCount;     // onRun() invocations
+    uint64_t runTime;           // total onRun() time (SM_PROFILE_CLOCK ticks, 64 bits:
+                                // a 32-bit cycle count wraps in seconds)
+    unsigned long runTimeMax;   // longest single onRun() (SM_PROFILE_CLOCK ticks)
+    unsigned long dwellTime;    // total time in state, current visit included (ms,
+                                // wraps with millis() after 49 days)
+    unsigned long entries;      // times entered
+    unsigned long exits;        // times exited
+    unsigned long interval;     // current polling interval (ms, see setAdaptiveInterval)
+};
+
 // Forward declaration
 class smMachine;
 
@@ -26,9 +78,59 @@ public:
     smAction* getAction() { return mAction; }
     const char* getName() const { return mName; }
 
+    // Position in the owning machine's state array (set by smMachine::begin)
+    void setIndex(smIndex_t index) { mIndex = index; }
+    smIndex_t getIndex() const { return mIndex; }
+
+    // Event-driven (tickless) states run onRun() once on entry and then
+    // sleep until signal(), an exit request, a posted event or a timeout,
+    // instead of polling every interval
+    void setEventDriven(bool enable) { mEventDriven = enable; }
+    bool isEventDriven() { return mEventDriven; }
+
+    // Adaptive polling: the interval doubles after every onRun() that
+    // returns false (no work done), up to maxInterval, and drops back to
+    // minInterval when onRun() does work, on signal() and on entry.
+    // maxInterval <= minInterval turns it off (fixed minInterval).
+    void setAdaptiveInterval(unsigned long minInterval, unsigned long maxInterval);
+    bool isAdaptive() { return mAdaptive; }
+    unsigned long getMinInterval() { return mMinInterval; }
+    unsigned long getMaxInterval() { return mMaxInterval; }
+    // Current interval, wherever the back-off has taken it (Task's, listed
+    // here as part of the adaptive API)
+    using Task::getInterval;
+
+    // Run onRun() on the next scheduler pass (wakes an event-driven state).
+    // Not ISR-safe: use smMachine::postSignal() from interrupts.
+    void signal() {
+        if (isEnabled()) {
+            if (mAdaptive) {
+                setInterval(mMinInterval);
+            }
+            forceNextIteration();
+        }
+    }
+
     // Time tracking
     unsigned long getEnterTime() { return mEnterTime; }
 
+    // Timeout on the machine's timer wheel (see smMachine::setTimerWheel):
+    // EXIT_TIMEOUT `timeout` ms after entry, 0 for none. On a wheel, a
+    // Task::setTimeout() value is moved here at the next entry.
+    void setWheelTimeout(unsigned long timeout) { mWheelTimeout = timeout; }
+    unsigned long getWheelTimeout() { return mWheelTimeout; }
+    smTimer& getTimer() { return mTimer; }
+
+    // Enable without onEnter(), as if entered `elapsed` ms ago
+    // (used by smMachine::restoreSnapshot)
+    void resume(unsigned long elapsed);
+
+#ifdef SM_PROFILING
+    // Profiling counters
+    void getStats(smStateStats& stats);
+    void resetStats();
+#endif
+
     // Lifecycle
     bool begin();
     void end();
@@ -39,8 +141,24 @@ public:
     void OnDisable() override;
 
 private:
+    static void onTimeout(smTimer& timer, void* state);
+    void armTimeout(unsigned long elapsed);
+
     smAction* mAction;
     smMachine* mMachine;
     const char* mName;
     unsigned long mEnterTime;
+    smIndex_t mIndex;
+    bool mEventDriven;
+    bool mResuming;
+    bool mAdaptive;
+    bool mDeviceStarting;       // a lazy device begun at entry is warming up
+    unsigned long mMinInterval;
+    unsigned long mMaxInterval;
+    unsigned long mWheelTimeout;
+    unsigned long mFullTimeout;     // Task timeout shortened by resume()
+    smTimer mTimer;
+#ifdef SM_PROFILING
+    smStateStats mStats;
+#endif
 };
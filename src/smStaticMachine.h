@@ -0,0 +1,137 @@
+#pragma once
+
+// =============================================================================
+// smStaticMachine.h - State machine with a compile-time transition table
+// =============================================================================
+// For tables that never change at runtime. Rows are template arguments:
+//
+//   smStaticMachine<
+//       smRow<&STATE_OFF, EXIT_BUTTON_PRESS, &STATE_ON>,
+//       smRow<&STATE_ON,  EXIT_BUTTON_PRESS, &STATE_OFF>,
+//       smRow<&STATE_ON,  EXIT_TIMEOUT,      &STATE_OFF>
+//   > fsm(states, NUM_STATES);
+//
+//   - Duplicate {fromState, exitCondition} pairs fail to compile, unless
+//     the earlier row has a guard: smRow<&STATE_ON, EXIT_GO, &STATE_RUN, isReady>
+//     (guards do not need SM_TRANSITION_GUARDS here)
+//   - SM_ANY_STATE / EXIT_ANY wildcard rows follow smMachine's precedence
+//   - findNextState() compiles to one pass of compares against immediates:
+//     a matching exact row returns at once, wildcard rows are only kept as
+//     the best candidate so far; no table walk, no table or index in RAM
+//   - States must have static storage duration (globals)
+//   - Snapshots carry a signature of the rows, so restoreSnapshot() rejects
+//     one saved with a different table
+// Everything else (begin/start/execute, smState, smAction) is smMachine.
+// =============================================================================
+
+#include "smMachine.h"
+
+template <smState* From, smExitCode_t ExitCondition, smState* To, smGuard Guard = nullptr>
+struct smRow {};
+
+// --- Compile-time checks ---
+
+// Two rows conflict when they share {fromState, exitCondition} and the
+// earlier one has no guard (the later one could never be taken)
+template <typename A, typename B>
+struct smRowConflict { static const bool value = false; };
+
+template <smState* F, smExitCode_t C, smState* T1, smGuard G1, smState* T2, smGuard G2>
+struct smRowConflict<smRow<F, C, T1, G1>, smRow<F, C, T2, G2> > { static const bool value = G1 == nullptr; };
+
+template <typename Row, typename... Rest>
+struct smRowConflictsAny { static const bool value = false; };
+
+template <typename Row, typename Next, typename... Rest>
+struct smRowConflictsAny<Row, Next, Rest...> {
+    static const bool value = smRowConflict<Row, Next>::value ||
+                              smRowConflictsAny<Row, Rest...>::value;
+};
+
+template <typename... Rows>
+struct smRowsUnique { static const bool value = true; };
+
+template <typename Row, typename... Rest>
+struct smRowsUnique<Row, Rest...> {
+    static const bool value = !smRowConflictsAny<Row, Rest...>::value &&
+                              smRowsUnique<Rest...>::value;
+};
+
+// --- Lookup ---
+
+// One pass in table order. A row's precedence level is known at compile
+// time (0 exact, 1 {state, EXIT_ANY}, 2 {SM_ANY_STATE, code}, 3 both
+// wildcards): a matching exact row ends the lookup, a wildcard row only
+// replaces a candidate of a worse level, so its guard is called only then
+template <typename... Rows>
+struct smRowLookup {
+    static inline smState* find(smState*, smExitCode_t, smState* best, uint8_t) { return best; }
+};
+
+template <smState* F, smExitCode_t C, smState* T, smGuard G, typename... Rest>
+struct smRowLookup<smRow<F, C, T, G>, Rest...> {
+    static const uint8_t level = (F == SM_ANY_STATE ? 2 : 0) + (C == EXIT_ANY ? 1 : 0);
+
+    static inline smState* find(smState* fromState, smExitCode_t exitCode,
+                                smState* best, uint8_t bestLevel) {
+        if ((C == EXIT_ANY || exitCode == C) && (F == SM_ANY_STATE || fromState == F) &&
+            level < bestLevel && (G == nullptr || G(fromState, exitCode))) {
+            if (level == 0) {
+                return T;
+            }
+            best = T;
+            bestLevel = level;
+        }
+        return smRowLookup<Rest...>::find(fromState, exitCode, best, bestLevel);
+    }
+};
+
+// --- Snapshot signature ---
+
+// CRC over every row's {from index, exit code, to index} in table order,
+// as smMachine does for a runtime table (SM_NO_INDEX for SM_ANY_STATE)
+inline smIndex_t smRowIndex(smState* state) {
+    return state ? state->getIndex() : (smIndex_t)SM_NO_INDEX;
+}
+
+template <typename... Rows>
+struct smRowSignature {
+    static uint16_t fold(uint16_t crc) { return crc; }
+};
+
+template <smState* F, smExitCode_t C, smState* T, smGuard G, typename... Rest>
+struct smRowSignature<smRow<F, C, T, G>, Rest...> {
+    static uint16_t fold(uint16_t crc) {
+        crc = smSnapshot::crc16(crc, smRowIndex(F));
+        crc = smSnapshot::crc16(crc, C);
+        crc = smSnapshot::crc16(crc, smRowIndex(T));
+        return smRowSignature<Rest...>::fold(crc);
+    }
+};
+
+template <typename... Rows>
+class smStaticMachine : public smMachine {
+    static_assert(sizeof...(Rows) < (unsigned long)SM_NO_INDEX, "smStaticMachine: too many transitions (see SM_INDEX_WIDTH)");
+    static_assert(smRowsUnique<Rows...>::value,
+                  "smStaticMachine: duplicate {fromState, exitCondition} transition");
+
+public:
+    smStaticMachine(smState* aStates[], smIndex_t aNumStates)
+        : smMachine(aStates, aNumStates, nullptr, 0) {}
+
+    smState* findNextState(smState* fromState, smExitCode_t exitCode) override {
+        if (!fromState) {
+            return nullptr;
+        }
+        return smRowLookup<Rows...>::find(fromState, exitCode, nullptr, 4);
+    }
+
+    // The rows are not in mTransitions[], so snapshots would not tell two
+    // compile-time tables apart without them
+    uint16_t computeTableSignature() override {
+        uint16_t crc = smSnapshot::crc16(smMachine::computeTableSignature(), (smIndex_t)sizeof...(Rows));
+        return smRowSignature<Rows...>::fold(crc);
+    }
+
+    static smIndex_t getNumTransitions() { return sizeof...(Rows); }
+};
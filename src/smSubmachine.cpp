@@ -0,0 +1,71 @@
+#include "smSubmachine.h"
+#include "smMachine.h"
+
+bool smSubmachine::begin() {
+    smMachine* owner = getMachine();
+    if (!owner || &mChild == owner || (mChild.mOwner && mChild.mOwner != owner)) {
+        return false;
+    }
+
+    // The composite state is the owner's state running this action
+    smState* composite = nullptr;
+    for (smIndex_t i = 0; i < owner->mNumStates && !composite; i++) {
+        if (owner->mStates[i] && owner->mStates[i]->getAction() == this) {
+            composite = owner->mStates[i];
+        }
+    }
+    if (!composite || (mChild.mComposite && mChild.mComposite != composite)) {
+        return false;
+    }
+    composite->setEventDriven(true);
+
+    if (mChild.mGroup) {
+        mChild.mGroup->remove(mChild);
+    }
+    mChild.mScheduler = owner->mScheduler;
+    if (!mChild.mWheel) {
+        mChild.mWheel = owner->mWheel;
+    }
+    mChild.mOwner = owner;
+    mChild.mComposite = composite;
+    // The child's devices warm up along with the owner's
+    mChild.mAsyncStartup = true;
+    return mChild.begin();
+}
+
+bool smSubmachine::pollStartup() {
+    return mChild.mStarting && mChild.pollStartup();
+}
+
+void smSubmachine::onEnter() {
+    // Active first, so exits bubble from the child's first onEnter()
+    getMachine()->mActiveChild = &mChild;
+    mChild.start(mInitialState);
+}
+
+void smSubmachine::onExit() {
+    mChild.stop();
+    if (getMachine()->mActiveChild == &mChild) {
+        getMachine()->mActiveChild = nullptr;
+    }
+}
+
+size_t smSubmachine::onSave(uint8_t* buffer, size_t size) {
+    return mChild.saveSnapshot(buffer, size);
+}
+
+bool smSubmachine::onRestore(const uint8_t* data, size_t size) {
+    if (mChild.isRunning()) {
+        mChild.stop();
+    }
+    getMachine()->mActiveChild = &mChild;
+    if (size) {
+        if (!mChild.restoreSnapshot(data, size)) {
+            getMachine()->mActiveChild = nullptr;
+            return false;
+        }
+        return true;
+    }
+    mChild.start(mInitialState);
+    return true;
+}
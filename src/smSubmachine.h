@@ -0,0 +1,58 @@
+#pragma once
+
+#include "smAction.h"
+#include "smState.h"
+
+// =============================================================================
+// smSubmachine - Composite state: an action that runs a child smMachine
+// =============================================================================
+// Sub-states without copying transition rows. The child machine has its
+// own states and table; entering the composite state starts it at
+// `initialState`, leaving it stops it:
+//
+//   smMachine connected(connStates, 3, connTransitions, 3);
+//   smSubmachine connectedAction(connected, &CONN_HANDSHAKE);
+//   smState STATE_CONNECTED(&connectedAction, "CONNECTED");
+//
+//   smTransition top[] = {
+//       { &STATE_IDLE,      EXIT_DIAL,       &STATE_CONNECTED },
+//       { &STATE_CONNECTED, EXIT_HANGUP,     &STATE_IDLE },   // from any sub-state
+//       { SM_ANY_STATE,     EXIT_ERROR,      &STATE_FAULT },
+//   };
+//
+// An exit code with no row in the child's table (EXIT_HANGUP requested by
+// a child state) bubbles up to the owner's rows for the composite state,
+// then on up through the owner's own owner, before onInvalidTransition()
+// is called. The owner's begin() begins the child and flattens that path
+// (see smMachine::getOwner()).
+//
+//   - The child runs on the owner's scheduler and leaves its group; only
+//     its current state is kept in the task chain. Do not execute() it.
+//   - The composite state is made event-driven: it only waits for the
+//     child (or its own timeout)
+//   - A snapshot of the owner in the composite state holds the child's
+//     snapshot as its payload; a child without room for its own restarts
+//     at `initialState`
+//   - A child machine belongs to one composite state
+// =============================================================================
+
+class smSubmachine : public smAction {
+public:
+    smSubmachine(smMachine& aChild, smState* aInitialState, const char* name = "SUBMACHINE")
+        : smAction(nullptr, name), mChild(aChild), mInitialState(aInitialState) {}
+
+    smMachine& getChild() { return mChild; }
+    smState* getInitialState() { return mInitialState; }
+
+    bool begin() override;
+    bool pollStartup() override;
+    void onEnter() override;
+    bool onRun() override { return false; }
+    void onExit() override;
+    size_t onSave(uint8_t* buffer, size_t size) override;
+    bool onRestore(const uint8_t* data, size_t size) override;
+
+private:
+    smMachine& mChild;
+    smState* mInitialState;
+};
@@ -0,0 +1,268 @@
+#include "smTimerWheel.h"
+#include "smMachine.h"
+
+#define SM_TIMER_MASK           (SM_TIMER_SLOTS - 1)
+
+// Slots from `index` + 1 on, wrapping, to the first one set in `bits`
+// (1 to SM_TIMER_SLOTS)
+static uint8_t slotsAhead(uint32_t bits, uint8_t index) {
+    const uint32_t all = 0xFFFFFFFFUL >> (32 - SM_TIMER_SLOTS);
+    uint8_t shift = (index + 1) & SM_TIMER_MASK;
+    uint32_t rotated = shift ? ((bits >> shift) | (bits << (SM_TIMER_SLOTS - shift))) & all : bits;
+#if defined(__AVR__)
+    uint8_t first = 0;
+    while (!(rotated & (1UL << first))) {
+        first++;
+    }
+#else
+    uint8_t first = (uint8_t)__builtin_ctzl(rotated);
+#endif
+    return first + 1;
+}
+
+// === smTimer ===
+
+smTimer::smTimer(smTimerHandler handler, void* context)
+    : mNext(nullptr)
+    , mPrev(nullptr)
+    , mWheel(nullptr)
+    , mExpiry(0)
+    , mLevel(0)
+    , mSlot(0)
+    , mKind(SM_TIMER_HANDLER)
+    , mExitCode(EXIT_NONE)
+    , mTarget(context)
+    , mHandler(handler)
+{
+}
+
+smTimer::smTimer(smAction& action, smExitCode_t exitCode) : smTimer() {
+    setTarget(action, exitCode);
+}
+
+void smTimer::setHandler(smTimerHandler handler, void* context) {
+    mKind = SM_TIMER_HANDLER;
+    mHandler = handler;
+    mTarget = context;
+}
+
+void smTimer::setTarget(smAction& action, smExitCode_t exitCode) {
+    mKind = SM_TIMER_ACTION;
+    mExitCode = exitCode;
+    mTarget = &action;
+    mHandler = nullptr;
+}
+
+unsigned long smTimer::getRemaining() {
+    if (!mWheel) {
+        return 0;
+    }
+    int32_t left = (int32_t)(mExpiry - (uint32_t)millis());
+    return left > 0 ? (unsigned long)left : 0;
+}
+
+void smTimer::cancel() {
+    if (mWheel) {
+        mWheel->unlink(*this);
+        mWheel->mCount--;
+        mWheel = nullptr;
+    }
+}
+
+void smTimer::expire() {
+    if (mKind == SM_TIMER_HANDLER) {
+        if (mHandler) {
+            mHandler(*this, mTarget);
+        }
+        return;
+    }
+    smAction* action = static_cast<smAction*>(mTarget);
+    smMachine* machine = action->getMachine();
+    smState* current = machine && machine->isRunning() ? machine->getCurrentState() : nullptr;
+    if (!current || current->getAction() != action) {
+        return;
+    }
+    if (mExitCode == EXIT_NONE) {
+        current->signal();
+    } else {
+        action->requestExit(mExitCode);
+    }
+}
+
+// === smTimerWheel ===
+
+smTimerWheel::smTimerWheel()
+    : Task(SM_SLEEP_FOREVER, TASK_FOREVER)
+    , mTick((uint32_t)millis())
+    , mWake(0)
+    , mAwake(false)
+    , mAdvancing(false)
+    , mCount(0)
+    , mExpired(0)
+{
+    memset(mSlots, 0, sizeof(mSlots));
+    memset(mOccupied, 0, sizeof(mOccupied));
+}
+
+smTimerWheel::~smTimerWheel() {
+    for (uint8_t level = 0; level < SM_TIMER_LEVELS; level++) {
+        for (uint8_t slot = 0; slot < SM_TIMER_SLOTS; slot++) {
+            for (smTimer* timer = mSlots[level][slot]; timer; timer = timer->mNext) {
+                timer->mWheel = nullptr;
+            }
+        }
+    }
+}
+
+void smTimerWheel::arm(smTimer& timer, unsigned long ms) {
+    timer.cancel();
+    uint32_t now = (uint32_t)millis();
+    if (!mCount && !mAdvancing) {
+        // Nothing left to fire before now (during advance() mTick may lag
+        // behind now, with the slot it is emptying still to finish)
+        mTick = now;
+    }
+    ms = ms < 1 ? 1 : ms > 0x7FFFFFFFUL ? 0x7FFFFFFFUL : ms;
+    timer.mExpiry = now + (uint32_t)ms;
+    timer.mWheel = this;
+    insert(timer);
+    mCount++;
+    // Wake the Task earlier if this timer is due before its next run
+    if (isEnabled() && (!mAwake || (int32_t)(timer.mExpiry - mWake) < 0)) {
+        mAwake = true;
+        mWake = timer.mExpiry;
+        delay(ms);
+    }
+}
+
+// Level: the lowest whose current block (one revolution of the level
+// below) holds the expiry; slot: its block within that level. The top
+// level is a ring; a timer more than one revolution away waits in the
+// slot reached last and is re-hashed from there.
+void smTimerWheel::insert(smTimer& timer) {
+    uint8_t level = 0;
+    uint8_t slot = mTick & SM_TIMER_MASK;
+    if ((int32_t)(timer.mExpiry - mTick) > 0) {
+        uint32_t diff = timer.mExpiry ^ mTick;
+        while (level < SM_TIMER_LEVELS - 1 && (diff >> (SM_TIMER_SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+        uint8_t shift = SM_TIMER_SLOT_BITS * level;
+        slot = (timer.mExpiry >> shift) & SM_TIMER_MASK;
+        if (level == SM_TIMER_LEVELS - 1) {
+            uint32_t blocks = ((timer.mExpiry >> shift) - (mTick >> shift)) & (0xFFFFFFFFUL >> shift);
+            if (blocks >= SM_TIMER_SLOTS) {
+                slot = ((mTick >> shift) - 1) & SM_TIMER_MASK;
+            }
+        }
+    }
+    timer.mLevel = level;
+    timer.mSlot = slot;
+    timer.mPrev = nullptr;
+    timer.mNext = mSlots[level][slot];
+    if (timer.mNext) {
+        timer.mNext->mPrev = &timer;
+    }
+    mSlots[level][slot] = &timer;
+    mOccupied[level] |= 1UL << slot;
+}
+
+void smTimerWheel::unlink(smTimer& timer) {
+    if (timer.mPrev) {
+        timer.mPrev->mNext = timer.mNext;
+    } else {
+        mSlots[timer.mLevel][timer.mSlot] = timer.mNext;
+        if (!timer.mNext) {
+            mOccupied[timer.mLevel] &= ~(1UL << timer.mSlot);
+        }
+    }
+    if (timer.mNext) {
+        timer.mNext->mPrev = timer.mPrev;
+    }
+}
+
+// mTick has just entered the block of `level`'s current slot: move its
+// timers down
+void smTimerWheel::cascade(uint8_t level) {
+    uint8_t slot = (mTick >> (SM_TIMER_SLOT_BITS * level)) & SM_TIMER_MASK;
+    while (smTimer* timer = mSlots[level][slot]) {
+        unlink(*timer);
+        insert(*timer);
+    }
+}
+
+// Ticks from mTick to the next slot with timers: its expiry on level 0,
+// otherwise the start of its block, when it cascades
+bool smTimerWheel::nextEvent(uint32_t& delta) {
+    for (uint8_t level = 0; level < SM_TIMER_LEVELS; level++) {
+        if (mOccupied[level]) {
+            uint8_t shift = SM_TIMER_SLOT_BITS * level;
+            uint32_t block = (mTick >> shift) + slotsAhead(mOccupied[level], (mTick >> shift) & SM_TIMER_MASK);
+            delta = (block << shift) - mTick;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned long smTimerWheel::getTimeToNext() {
+    uint32_t delta;
+    if (!mCount || !nextEvent(delta)) {
+        return SM_SLEEP_FOREVER;
+    }
+    int32_t left = (int32_t)(mTick + delta - (uint32_t)millis());
+    return left > 0 ? (unsigned long)left : 0;
+}
+
+unsigned long smTimerWheel::advance() {
+    uint32_t now = (uint32_t)millis();
+    unsigned long fired = 0;
+    uint32_t delta;
+    mAdvancing = true;
+    // Slot by slot with timers in it; empty stretches are skipped
+    while (mCount && nextEvent(delta) && delta <= now - mTick) {
+        mTick += delta;
+        for (uint8_t level = SM_TIMER_LEVELS - 1; level > 0; level--) {
+            if (!(mTick & ((1UL << (SM_TIMER_SLOT_BITS * level)) - 1))) {
+                cascade(level);
+            }
+        }
+        uint8_t slot = mTick & SM_TIMER_MASK;
+        while (smTimer* timer = mSlots[0][slot]) {
+            unlink(*timer);
+            if ((int32_t)(timer->mExpiry - mTick) > 0) {
+                // A single-level wheel's ring: not this revolution
+                insert(*timer);
+                continue;
+            }
+            timer->mWheel = nullptr;
+            mCount--;
+            mExpired++;
+            fired++;
+            timer->expire();
+        }
+    }
+    mAdvancing = false;
+    mTick = now;
+    return fired;
+}
+
+void smTimerWheel::reschedule() {
+    unsigned long next = getTimeToNext();
+    mAwake = next != SM_SLEEP_FOREVER;
+    mWake = (uint32_t)millis() + (uint32_t)next;
+    delay(next);
+}
+
+bool smTimerWheel::OnEnable() {
+    // enable() makes the Task due at once
+    mAwake = true;
+    mWake = (uint32_t)millis();
+    return true;
+}
+
+bool smTimerWheel::Callback() {
+    unsigned long fired = advance();
+    reschedule();
+    return fired > 0;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Ensure OO callbacks are enabled for TaskScheduler
+#ifndef _TASK_OO_CALLBACKS
+#define _TASK_OO_CALLBACKS
+#endif
+
+#include <TaskSchedulerDeclarations.h>
+#include "smAction.h"
+
+// =============================================================================
+// smTimerWheel - Hierarchical timer wheel for state timeouts and delays
+// =============================================================================
+// Timers are intrusive list nodes (smTimer) hashed by expiry time into
+// SM_TIMER_LEVELS levels of 2^SM_TIMER_SLOT_BITS slots: level 0 holds one
+// millisecond per slot, each level above one whole revolution of the level
+// below. arm() and cancel() are constant time; a run of the wheel fires the
+// timers in the slot now due and moves each timer of a higher-level slot
+// down once its time is within that level's reach (at most once per level
+// per timer). Occupancy bitmaps let a run skip empty slots, so the wheel
+// Task sleeps until the next slot with timers in it.
+//
+//   smTimerWheel wheel;
+//   fsm.setTimerWheel(&wheel);               // before begin()
+//   STATE_ON.setTimeout(5000);               // moved onto the wheel
+//   fsm.begin();
+//   fsm.getScheduler().addTask(wheel);
+//   wheel.enable();
+//
+// Timers fire from the wheel Task, on the scheduler that runs it, so arm
+// and cancel them from that thread (not from ISRs). A timer expires into:
+//   - a handler, called with the timer and a context pointer
+//   - an action and exit code: requestExit(exitCode) if the action's
+//     state is current (EXIT_NONE: signal() the state instead)
+//
+//   class DebounceAction : public smAction {
+//       smTimer mSettle{ *this, EXIT_USER };
+//       void onEnter() override { wheel.arm(mSettle, 20); }
+//   };
+//
+// Delays longer than the wheel's span wait in its top level and are moved
+// down as they come within reach.
+// =============================================================================
+
+// Slots per level (2^bits) and levels; the wheel spans
+// 2^(bits * levels) ms without re-hashing (17.5 min, 65 s on AVR)
+#ifndef SM_TIMER_SLOT_BITS
+#if defined(__AVR__)
+#define SM_TIMER_SLOT_BITS      4
+#else
+#define SM_TIMER_SLOT_BITS      5
+#endif
+#endif
+#ifndef SM_TIMER_LEVELS
+#define SM_TIMER_LEVELS         4
+#endif
+
+#define SM_TIMER_SLOTS          (1U << SM_TIMER_SLOT_BITS)
+
+static_assert(SM_TIMER_SLOT_BITS >= 1 && SM_TIMER_SLOT_BITS <= 5, "smTimerWheel: SM_TIMER_SLOT_BITS must be 1 to 5");
+static_assert(SM_TIMER_LEVELS >= 1 && SM_TIMER_SLOT_BITS * SM_TIMER_LEVELS <= 32,
+              "smTimerWheel: SM_TIMER_LEVELS * SM_TIMER_SLOT_BITS must be at most 32");
+
+class smTimer;
+class smTimerWheel;
+
+typedef void (*smTimerHandler)(smTimer& timer, void* context);
+
+class smTimer {
+public:
+    smTimer(smTimerHandler handler = nullptr, void* context = nullptr);
+    smTimer(smAction& action, smExitCode_t exitCode);
+    ~smTimer() { cancel(); }
+
+    void setHandler(smTimerHandler handler, void* context = nullptr);
+    void setTarget(smAction& action, smExitCode_t exitCode);
+
+    // Armed on a wheel and not yet expired or cancelled
+    bool isArmed() { return mWheel != nullptr; }
+    smTimerWheel* getWheel() { return mWheel; }
+
+    // Milliseconds until expiry (0 if due or not armed)
+    unsigned long getRemaining();
+
+    void cancel();
+
+private:
+    friend class smTimerWheel;
+
+    enum : uint8_t { SM_TIMER_HANDLER, SM_TIMER_ACTION };
+
+    void expire();
+
+    smTimer* mNext;
+    smTimer* mPrev;
+    smTimerWheel* mWheel;
+    uint32_t mExpiry;           // millis() when due
+    uint8_t mLevel;
+    uint8_t mSlot;
+    uint8_t mKind;
+    smExitCode_t mExitCode;
+    void* mTarget;              // action or handler context
+    smTimerHandler mHandler;
+};
+
+class smTimerWheel : public Task {
+public:
+    smTimerWheel();
+    ~smTimerWheel();
+
+    // (Re-)arm `timer` to expire `ms` milliseconds from now (at least 1);
+    // moves it off any other wheel
+    void arm(smTimer& timer, unsigned long ms);
+    void cancel(smTimer& timer) { timer.cancel(); }
+
+    // Timers armed, and timers fired since construction
+    unsigned long getCount() { return mCount; }
+    unsigned long getExpired() { return mExpired; }
+
+    // Milliseconds of timeline that fit without re-hashing
+    static unsigned long span() { return 0xFFFFFFFFUL >> (32 - SM_TIMER_SLOT_BITS * SM_TIMER_LEVELS); }
+
+    // Milliseconds until the next slot with timers is processed
+    // (SM_SLEEP_FOREVER if none are armed)
+    unsigned long getTimeToNext();
+
+    // Fire every timer due by millis(); returns how many fired. The Task
+    // calls it and then sleeps until the next slot with timers; call it
+    // from loop() instead to run the wheel without a scheduler.
+    unsigned long advance();
+
+    bool OnEnable() override;
+    bool Callback() override;
+
+private:
+    friend class smTimer;
+
+    void insert(smTimer& timer);
+    void unlink(smTimer& timer);
+    void cascade(uint8_t level);
+    bool nextEvent(uint32_t& delta);
+    void reschedule();
+
+    // mSlots[level][slot]: timers by expiry; bit `slot` of
+    // mOccupied[level] is set while that list is not empty
+    smTimer* mSlots[SM_TIMER_LEVELS][SM_TIMER_SLOTS];
+    uint32_t mOccupied[SM_TIMER_LEVELS];
+
+    // Every timer due at or before mTick has fired
+    uint32_t mTick;
+    uint32_t mWake;             // millis() the Task next runs, if mAwake
+    bool mAwake;
+    bool mAdvancing;            // in advance(): handlers may arm timers
+    unsigned long mCount;
+    unsigned long mExpired;
+};